@@ -0,0 +1,125 @@
+#include "Animation.h"
+#include "Utility.h"
+#include "GLState.h"
+#include <cmath>
+#include <iostream>
+
+std::mutex Animation::mutex;
+
+std::vector<glm::vec4> Animation::frames;
+std::vector<glm::vec4> Animation::clips;
+bool Animation::dirty = true;
+
+GLuint Animation::program_id = 0;
+GLint Animation::time_uniform = -1;
+GLint Animation::frames_uniform = -1;
+GLint Animation::clips_uniform = -1;
+
+Uint64 Animation::epoch = 0;
+
+int Animation::add_clip(const glm::vec4 *frame_rectangles, int frame_count)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // STEP 1: Scenes ask for the same walk cycle more than once; hand back the clip they already have
+    for (int clip = 0; clip < (int) clips.size(); clip++)
+    {
+        int first = (int) clips[clip].x;
+        if ((int) clips[clip].y != frame_count) continue;
+
+        bool same = true;
+        for (int i = 0; i < frame_count && same; i++) same = frames[first + i] == frame_rectangles[i];
+        if (same) return clip + 1;
+    }
+
+    // Full tables aren't fatal: clip 0 tells the caller to pick frames itself and draw them still
+    if ((int) frames.size() + frame_count > MAX_FRAMES || (int) clips.size() >= MAX_CLIPS)
+    {
+        LOG("Animation tables are full: " << MAX_CLIPS << " clips of " << MAX_FRAMES << " frames in total.");
+        return 0;
+    }
+
+    // STEP 2: Append the frames and the clip that points at them; the shader gets them on the next apply()
+    clips.push_back(glm::vec4((float) frames.size(), (float) frame_count, 0.0f, 0.0f));
+    frames.insert(frames.end(), frame_rectangles, frame_rectangles + frame_count);
+    dirty = true;
+
+    return (int) clips.size();
+}
+
+int Animation::add_clip(const AtlasRegion &region, int columns, int rows, const int *indices, int frame_count)
+{
+    float width = region.width / (float) columns;
+    float height = region.height / (float) rows;
+
+    std::vector<glm::vec4> frame_rectangles;
+    for (int i = 0; i < frame_count; i++)
+    {
+        frame_rectangles.push_back(glm::vec4(region.u + (float) (indices[i] % columns) * width,
+                                             region.v + (float) (indices[i] / columns) * height,
+                                             width, height));
+    }
+
+    return add_clip(frame_rectangles.data(), frame_count);
+}
+
+void Animation::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    frames.clear();
+    clips.clear();
+    dirty = true;
+}
+
+void Animation::apply(ShaderProgram *program)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (program->programID != program_id)
+    {
+        program_id = program->programID;
+        time_uniform = glGetUniformLocation(program_id, "time");
+        frames_uniform = glGetUniformLocation(program_id, "animationFrames");
+        clips_uniform = glGetUniformLocation(program_id, "animationClips");
+        dirty = true;
+    }
+
+    GLState::use_program(program_id);
+    glUniform1f(time_uniform, now());
+
+    // Only when a scene added or dropped clips
+    if (!dirty) return;
+
+    if (!frames.empty()) glUniform4fv(frames_uniform, (GLsizei) frames.size(), &frames[0].x);
+    if (!clips.empty())  glUniform4fv(clips_uniform, (GLsizei) clips.size(), &clips[0].x);
+    dirty = false;
+}
+
+float Animation::now()
+{
+    // Seconds since the first call, so a float keeps millisecond steps for hours
+    Uint64 counter = SDL_GetPerformanceCounter();
+    if (epoch == 0) epoch = counter;
+
+    return (float) ((double) (counter - epoch) / (double) SDL_GetPerformanceFrequency());
+}
+
+bool Animation::frame_rectangle(const glm::vec4 &animation, float time, glm::vec4 *rectangle)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    int clip = (int) (animation.x + 0.5f);
+    if (clip <= 0 || clip > (int) clips.size()) return false;
+
+    int frame = frame_at(time, (int) clips[clip - 1].y, animation.z, animation.y, (int) animation.w);
+    *rectangle = frames[(int) clips[clip - 1].x + frame];
+    return true;
+}
+
+int Animation::frame_at(float time, int frame_count, float start_time, float rate, int start_frame)
+{
+    // Same arithmetic as the vertex shader
+    int frame = start_frame + (int) floor((time - start_time) * rate);
+    return ((frame % frame_count) + frame_count) % frame_count;
+}
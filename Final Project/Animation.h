@@ -0,0 +1,70 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <mutex>
+#include <vector>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "ShaderProgram.h"
+#include "TextureAtlas.h"
+
+/**
+ Animation clips as frame tables that live in the uber-shader's uniforms.
+ A clip is a run of frame rectangles (UV space); a sprite or tile names its
+ clip, the time it started, its rate and the frame it started on, and the
+ vertex shader picks the frame from the global time uniform. Nothing is
+ re-uploaded per frame except that time, so a playing animation costs the
+ CPU nothing until it is started, stopped or switched.
+
+ Clip ids start at 1; clip 0 means a still frame and is what every draw
+ that doesn't say otherwise gets.
+ */
+class Animation {
+private:
+    // Guards the tables: scenes add clips while loading, the render thread uploads them
+    static std::mutex mutex;
+
+    static std::vector<glm::vec4> frames;   // (u, v, width, height)
+    static std::vector<glm::vec4> clips;    // (first frame, frame count, -, -), from clip 1 on
+    static bool dirty;
+
+    static GLuint program_id;
+    static GLint time_uniform, frames_uniform, clips_uniform;
+
+    static Uint64 epoch;
+
+public:
+    // Keep these in step with the constants in VERTEX_UBER_SHADER_SOURCE; both
+    // tables together have to stay inside GL 2.1's 128 vertex uniform vectors
+    static const int MAX_FRAMES = 64;
+    static const int MAX_CLIPS = 16;
+
+    // Returns the clip id; a table identical to one already added shares its id.
+    // Returns 0 once the tables are full, and the caller draws still frames instead
+    static int add_clip(const glm::vec4 *frame_rectangles, int frame_count);
+
+    // Frames picked out of a columns x rows sprite sheet, the same way
+    // Entity::draw_sprite_from_texture_atlas picks them
+    static int add_clip(const AtlasRegion &region, int columns, int rows, const int *indices, int frame_count);
+
+    // A new scene brings its own atlas, so its clips start from scratch
+    static void clear();
+
+    // Render thread, once per frame: the time, and the tables if they changed
+    static void apply(ShaderProgram *program);
+
+    // Seconds on the clock the shader animates by
+    static float now();
+
+    // The frame the shader shows for these parameters at time, for the CPU paths that still need it
+    static int frame_at(float time, int frame_count, float start_time, float rate, int start_frame);
+
+    // The rectangle the shader would map a draw's unit UVs onto; false for a still frame
+    static bool frame_rectangle(const glm::vec4 &animation, float time, glm::vec4 *rectangle);
+};
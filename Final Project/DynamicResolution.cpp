@@ -0,0 +1,99 @@
+#include "DynamicResolution.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+DynamicResolution::DynamicResolution(float min_scale, float max_scale, float budget_ms)
+{
+    this->min_scale = min_scale;
+    this->max_scale = max_scale;
+    this->budget_ms = budget_ms;
+    this->scale = max_scale;
+    
+#ifdef GL_TIME_ELAPSED
+    // Core in 3.3; older contexts may still have one of the extensions
+    const char *extensions = (const char *) glGetString(GL_EXTENSIONS);
+    this->has_timer_queries = extensions != NULL && (strstr(extensions, "GL_ARB_timer_query") != NULL ||
+                                                     strstr(extensions, "GL_EXT_timer_query") != NULL);
+#ifdef _WINDOWS
+    if (glBeginQuery == NULL || glGetQueryObjectui64v == NULL) this->has_timer_queries = false;
+#endif
+    
+    if (this->has_timer_queries) glGenQueries(QUERY_COUNT, this->queries);
+#endif
+}
+
+DynamicResolution::~DynamicResolution()
+{
+#ifdef GL_TIME_ELAPSED
+    if (this->has_timer_queries) glDeleteQueries(QUERY_COUNT, this->queries);
+#endif
+}
+
+void DynamicResolution::read_finished_query()
+{
+#ifdef GL_TIME_ELAPSED
+    GLuint query = this->queries[this->query_index];
+    
+    GLuint available = 0;
+    glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return;
+    
+    GLuint64 elapsed_ns = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_ns);
+    this->gpu_ms = (float) elapsed_ns / 1000000.0f;
+    this->query_pending[this->query_index] = false;
+#endif
+}
+
+void DynamicResolution::begin_frame()
+{
+#ifdef GL_TIME_ELAPSED
+    if (!this->has_timer_queries) return;
+    
+    // The slot we are about to reuse was issued QUERY_COUNT frames ago; if the
+    // driver still hasn't finished it, this frame just goes untimed
+    if (this->query_pending[this->query_index]) this->read_finished_query();
+    
+    this->timing = !this->query_pending[this->query_index];
+    if (this->timing) glBeginQuery(GL_TIME_ELAPSED, this->queries[this->query_index]);
+#endif
+}
+
+void DynamicResolution::end_frame(float cpu_ms)
+{
+#ifdef GL_TIME_ELAPSED
+    if (this->timing)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        this->query_pending[this->query_index] = true;
+        this->timing = false;
+    }
+    if (this->has_timer_queries) this->query_index = (this->query_index + 1) % QUERY_COUNT;
+#endif
+    
+    // STEP 1: Whichever side is slower is what the frame costs
+    float frame_ms = std::max(cpu_ms, this->gpu_ms);
+    this->smoothed_ms = (this->smoothed_ms == 0.0f) ? frame_ms : this->smoothed_ms * 0.9f + frame_ms * 0.1f;
+    
+    if (++this->frames_since_adjust < ADJUST_INTERVAL) return;
+    
+    // STEP 2: Fill cost goes with the pixel count, i.e. the square of the scale
+    float target_scale = this->scale;
+    if (this->smoothed_ms > this->budget_ms)
+    {
+        target_scale = this->scale * sqrtf(this->budget_ms / this->smoothed_ms);
+        target_scale = std::max(target_scale, this->scale - 0.1f);
+    }
+    else if (this->smoothed_ms < this->budget_ms * 0.75f)
+    {
+        target_scale = this->scale + 0.05f;
+    }
+    
+    target_scale = std::min(std::max(target_scale, this->min_scale), this->max_scale);
+    if (target_scale != this->scale)
+    {
+        this->scale = target_scale;
+        this->frames_since_adjust = 0;
+    }
+}
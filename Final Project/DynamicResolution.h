@@ -0,0 +1,53 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+
+/**
+ Picks the scale the scene is rendered at so a frame fits its time budget.
+ GPU time comes from timer queries read a few frames late (so nothing ever
+ waits on them), CPU time from the caller; the slower of the two drives the
+ scale between its bounds. Scale drops as soon as a frame is over budget and
+ only creeps back up once there is clear headroom, so it does not oscillate.
+ Render thread only.
+ */
+class DynamicResolution {
+private:
+    // Frames a timer query gets to finish before we look at it
+    static const int QUERY_COUNT = 4;
+    // Frames between two scale changes, so each change shows up in the timings first
+    static const int ADJUST_INTERVAL = 15;
+
+    float min_scale, max_scale;
+    float budget_ms;
+    float scale;
+
+    float smoothed_ms = 0.0f;
+    float gpu_ms = 0.0f;
+    int frames_since_adjust = 0;
+
+    bool has_timer_queries = false;
+    GLuint queries[QUERY_COUNT] = {};
+    bool query_pending[QUERY_COUNT] = {};
+    int query_index = 0;
+    bool timing = false;
+
+    void read_finished_query();
+
+public:
+    DynamicResolution(float min_scale, float max_scale, float budget_ms);
+    ~DynamicResolution();
+
+    // Bracket everything the frame draws, composite included
+    void begin_frame();
+    void end_frame(float cpu_ms);
+
+    float const get_scale()  const { return this->scale;  }
+    float const get_gpu_ms() const { return this->gpu_ms; }
+};
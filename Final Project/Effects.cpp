@@ -1,128 +1,201 @@
 #include "Effects.h"
+#include "GLState.h"
+#include "RenderStats.h"
+#include "ShaderCache.h"
+#include "ShaderSources.h"
+#include <algorithm>
 
-Effects::Effects(glm::mat4 projection_matrix, glm::mat4 view_matrix)
+Effects::Effects(int width, int height)
 {
-    // Non textured Shader
-    program.Load("shaders/vertex.glsl", "shaders/fragment.glsl");
-    program.SetProjectionMatrix(projection_matrix);
-    program.SetViewMatrix(view_matrix);
+    // One program for every effect at once, shared with every other Effects
+    ShaderCache::load(program, VERTEX_COMPOSITE_SHADER_SOURCE, FRAGMENT_COMPOSITE_SHADER_SOURCE);
     
-    this->current_effect = NONE;
-    this->alpha = 1.0f;
-    this->effect_speed = 1.0;
-    this->size = 10.0f;
+    this->fade_uniform         = glGetUniformLocation(this->program.programID, "fade");
+    this->cover_uniform        = glGetUniformLocation(this->program.programID, "cover");
+    this->aspect_uniform       = glGetUniformLocation(this->program.programID, "aspect");
+    this->shake_offset_uniform = glGetUniformLocation(this->program.programID, "shakeOffset");
+    this->tint_uniform         = glGetUniformLocation(this->program.programID, "tint");
+    this->uv_scale_uniform     = glGetUniformLocation(this->program.programID, "uvScale");
+    this->uv_max_uniform       = glGetUniformLocation(this->program.programID, "uvMax");
     
-    this->view_offset = glm::vec3(0.0f);
-}
-
-void Effects::draw_overlay()
-{
-    glUseProgram(this->program.programID);
-
-    float vertices[] =
+    // A full-screen quad in clip space: x, y, u, v
+    float quad[] =
     {
-        -0.5, -0.5,
-         0.5, -0.5,
-         0.5,  0.5,
-        
-        -0.5, -0.5,
-         0.5,  0.5,
-        -0.5,  0.5
+        -1.0, -1.0, 0.0, 0.0,
+         1.0, -1.0, 1.0, 0.0,
+         1.0,  1.0, 1.0, 1.0,
+        -1.0, -1.0, 0.0, 0.0,
+         1.0,  1.0, 1.0, 1.0,
+        -1.0,  1.0, 0.0, 1.0
     };
+    
+    glGenBuffers(1, &this->quad_buffer_id);
+    GLState::bind_array_buffer(this->quad_buffer_id);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    
+    this->width = width;
+    this->height = height;
+    this->target.resize(width, height);
+    this->scaled_width = width;
+    this->scaled_height = height;
+    
+    this->fade_effect = NONE;
+    this->iris_effect = NONE;
+    this->alpha = 0.0f;
+    this->size = 0.0f;
+    this->time_left = 0.0f;
+    this->fade_speed = this->iris_speed = this->shake_speed = 1.0f;
+    
+    this->shake_offset = glm::vec2(0.0f);
+    this->tint = glm::vec3(1.0f);
+}
 
-    glVertexAttribPointer(this->program.positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-    glEnableVertexAttribArray(this->program.positionAttribute);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glDisableVertexAttribArray(this->program.positionAttribute);
+Effects::~Effects()
+{
+    GLState::delete_buffer(this->quad_buffer_id);
 }
 
 void Effects::start(EffectType effect_type, float effect_speed)
 {
-    this->current_effect = effect_type;
-    this->effect_speed = effect_speed;
-
-    switch (this->current_effect)
+    // Each kind of effect replaces only its own kind, so a fade and a shake can overlap
+    switch (effect_type)
     {
-        case NONE:                             break;
-        case FADEIN:  this->alpha     = 1.0f;  break;
-        case FADEOUT: this->alpha     = 0.0f;  break;
-        case GROW:    this->size      = 0.0f;  break;
-        case SHRINK:  this->size      = 10.0f; break;
-        case SHAKE:   this->time_left = 1.0f;  break;
+        case NONE:
+            this->fade_effect = NONE;
+            this->iris_effect = NONE;
+            this->alpha = 0.0f;
+            this->size = 0.0f;
+            this->time_left = 0.0f;
+            this->shake_offset = glm::vec2(0.0f);
+            break;
+            
+        case FADEIN:  this->fade_effect = FADEIN;  this->fade_speed  = effect_speed; this->alpha     = 1.0f;       break;
+        case FADEOUT: this->fade_effect = FADEOUT; this->fade_speed  = effect_speed; this->alpha     = 0.0f;       break;
+        case GROW:    this->iris_effect = GROW;    this->iris_speed  = effect_speed; this->size      = 0.0f;       break;
+        case SHRINK:  this->iris_effect = SHRINK;  this->iris_speed  = effect_speed; this->size      = FULL_SIZE;  break;
+        case SHAKE:                                this->shake_speed = effect_speed; this->time_left = 1.0f;       break;
     }
 }
 
 
 void Effects::update(float delta_time)
 {
-   switch (this->current_effect)
-   {
-       case NONE: break;
-           
-       // Fades
-       case FADEIN:
-           this->alpha -= delta_time * this->effect_speed;
-           if (this->alpha <= 0) this->current_effect = NONE;
-           
-           break;
-       case FADEOUT:
-           if (this->alpha < 1.0f) this->alpha += delta_time * this->effect_speed;
-           
-           break;
-           
-       case GROW:
-           if (this->size < 10.0f) this->size += delta_time * this->effect_speed; break;
-           
-       case SHRINK:
-           if (this->size >= 0.0f) this->size -= delta_time * this->effect_speed;
-           if (this->size < 0) this->current_effect = NONE;
-           
-           break;
-           
-       case SHAKE:
-           this->time_left -= delta_time * this->effect_speed;
-           if (this->time_left <= 0.0f)
-           {
-               this->view_offset = glm::vec3(0.0f, 0.0f, 0.0f);
-               this->current_effect = NONE;
-           } else
-           {
-               float min = -0.1f;
-               float max =  0.0f;
-               float offset_value = ((float) rand() / RAND_MAX) * (max - min) + min;
-               this->view_offset = glm::vec3(offset_value, offset_value, 0.0f);
-           }
-   }
-}
-
-void Effects::render()
-{
-    glm::mat4 model_matrix = glm::mat4(1.0f);
-
-    switch (this->current_effect)
+    // Fades
+    switch (this->fade_effect)
     {
-        case NONE:
+        case FADEIN:
+            this->alpha -= delta_time * this->fade_speed;
+            if (this->alpha <= 0)
+            {
+                this->alpha = 0.0f;
+                this->fade_effect = NONE;
+            }
             break;
             
-        case GROW:
-        case SHRINK:
         case FADEOUT:
-        case FADEIN:
-            // Expand the current square a bit
-            model_matrix = glm::scale(model_matrix,
-                                      glm::vec3(this->size,
-                                                this->current_effect != GROW && this->current_effect != SHRINK ?
-                                                    this->size : this->size * 0.75f,
-                                                0.0f));
+            if (this->alpha < 1.0f) this->alpha = fmin(this->alpha + delta_time * this->fade_speed, 1.0f);
+            break;
             
-            this->program.SetModelMatrix(model_matrix);
-            this->program.SetColor(0.0f, 0.0f, 0.0f, this->alpha);
-            this->draw_overlay();
-
+        default:
+            break;
+    }
+    
+    // Iris
+    switch (this->iris_effect)
+    {
+        case GROW:
+            if (this->size < FULL_SIZE) this->size = fmin(this->size + delta_time * this->iris_speed, FULL_SIZE);
             break;
             
-        case SHAKE:
-            // Shake doesn't change the model matrix, so we're good here
+        case SHRINK:
+            if (this->size >= 0.0f) this->size -= delta_time * this->iris_speed;
+            if (this->size < 0)
+            {
+                this->size = 0.0f;
+                this->iris_effect = NONE;
+            }
             break;
+            
+        default:
+            break;
+    }
+    
+    // Shake
+    if (this->time_left > 0.0f)
+    {
+        this->time_left -= delta_time * this->shake_speed;
+        if (this->time_left <= 0.0f)
+        {
+            this->shake_offset = glm::vec2(0.0f);
+        } else
+        {
+            // Same world-space jitter as before, in the 10 x 7.5 unit view's UV space
+            float min = -0.1f;
+            float max =  0.0f;
+            float offset_value = ((float) rand() / RAND_MAX) * (max - min) + min;
+            this->shake_offset = glm::vec2(offset_value / 10.0f, offset_value / 7.5f);
+        }
     }
 }
+
+PostProcess const Effects::get_post_process() const
+{
+    PostProcess post_process;
+    post_process.fade = this->alpha;
+    post_process.cover = this->size / FULL_SIZE;
+    post_process.shake_offset = this->shake_offset;
+    post_process.tint = this->tint;
+    
+    return post_process;
+}
+
+void Effects::begin(const PostProcess &post_process)
+{
+    // Nothing to composite: draw straight to the window and skip the extra pass
+    this->drawing_offscreen = !post_process.is_identity() || this->resolution_scale < 1.0f;
+    if (!this->drawing_offscreen) return;
+    
+    // The target stays full size; a smaller scale only shrinks the viewport into it
+    this->target.bind();
+    glViewport(0, 0, this->scaled_width, this->scaled_height);
+}
+
+void Effects::set_resolution_scale(float scale)
+{
+    this->resolution_scale = scale;
+    this->scaled_width  = std::max(1, (int) roundf(this->width * scale));
+    this->scaled_height = std::max(1, (int) roundf(this->height * scale));
+}
+
+void Effects::end(const PostProcess &post_process)
+{
+    if (!this->drawing_offscreen) return;
+    this->drawing_offscreen = false;
+    
+    this->target.unbind();
+    glViewport(0, 0, this->width, this->height);
+    
+    GLState::use_program(this->program.programID);
+    glUniform1f(this->fade_uniform, post_process.fade);
+    glUniform1f(this->cover_uniform, post_process.cover);
+    glUniform1f(this->aspect_uniform, (float) this->width / (float) this->height);
+    glUniform2f(this->shake_offset_uniform, post_process.shake_offset.x, post_process.shake_offset.y);
+    glUniform3f(this->tint_uniform, post_process.tint.r, post_process.tint.g, post_process.tint.b);
+    
+    // Upscale: nearest filtering on the target keeps the pixels square-edged
+    glUniform2f(this->uv_scale_uniform, (float) this->scaled_width / this->width, (float) this->scaled_height / this->height);
+    glUniform2f(this->uv_max_uniform, (this->scaled_width - 0.5f) / this->width, (this->scaled_height - 0.5f) / this->height);
+    
+    GLsizei stride = 4 * sizeof(float);
+    GLState::bind_array_buffer(this->quad_buffer_id);
+    glVertexAttribPointer(this->program.positionAttribute, 2, GL_FLOAT, false, stride, (void *) 0);
+    glVertexAttribPointer(this->program.texCoordAttribute, 2, GL_FLOAT, false, stride, (void *) (2 * sizeof(float)));
+    GLState::use_attributes({ (GLint) this->program.positionAttribute, (GLint) this->program.texCoordAttribute });
+    
+    // Opaque copy; blending would mix in whatever the window held last frame
+    glDisable(GL_BLEND);
+    GLState::bind_texture(this->target.get_texture_id());
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    RenderStats::count_draw(6);
+    glEnable(GL_BLEND);
+}
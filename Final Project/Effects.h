@@ -13,24 +13,70 @@
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
+#include "RenderTarget.h"
 
 enum EffectType { NONE, FADEIN, FADEOUT, GROW, SHRINK, SHAKE };
 
+/**
+ The composite inputs for one frame. Plain values, so the simulation can
+ hand them to the render thread along with the rest of a snapshot.
+ */
+struct PostProcess
+{
+    float fade = 0.0f;                       // 0 = scene, 1 = black
+    float cover = 0.0f;                      // black iris, 1 covers the screen
+    glm::vec2 shake_offset = glm::vec2(0.0f); // UV space
+    glm::vec3 tint = glm::vec3(1.0f);
+    
+    bool const is_identity() const
+    {
+        return fade <= 0.0f && cover <= 0.0f && shake_offset == glm::vec2(0.0f) && tint == glm::vec3(1.0f);
+    }
+};
+
+/**
+ Screen effects as a post-process: the scene is drawn once into an offscreen
+ target and every active effect is applied in one full-screen composite.
+ Fades, the iris and shake each keep their own state, so they stack.
+ */
 class Effects {
-    ShaderProgram program;
+    // Simulation side
     float alpha;
-    float effect_speed;
     float size;
     float time_left;
-    EffectType current_effect;
+    float fade_speed, iris_speed, shake_speed;
+    EffectType fade_effect, iris_effect;
+    glm::vec2 shake_offset;
+    glm::vec3 tint;
+    
+    // GL side
+    ShaderProgram program;
+    GLint fade_uniform, cover_uniform, aspect_uniform, shake_offset_uniform, tint_uniform;
+    GLint uv_scale_uniform, uv_max_uniform;
+    GLuint quad_buffer_id = 0;
+    RenderTarget target;
+    int width, height;
+    bool drawing_offscreen = false;
+    
+    // Below 1 the scene is drawn into the corner of the target and upscaled by the composite
+    float resolution_scale = 1.0f;
+    int scaled_width, scaled_height;
 
 public:
-    glm::vec3 view_offset;
+    static constexpr float FULL_SIZE = 10.0f; // iris size that covers the screen
     
-    Effects(glm::mat4 projection_matrix, glm::mat4 view_matrix);
+    Effects(int width, int height);
+    ~Effects();
 
-    void draw_overlay();
     void start(EffectType effect_type, float effect_speed);
     void update(float delta_time);
-    void render();
+    void set_tint(glm::vec3 new_tint) { this->tint = new_tint; }
+    
+    PostProcess const get_post_process() const;
+    
+    // Render thread: wrap the scene's draws; both do nothing for an identity
+    // frame at full resolution
+    void set_resolution_scale(float scale);
+    void begin(const PostProcess &post_process);
+    void end(const PostProcess &post_process);
 };
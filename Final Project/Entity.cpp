@@ -15,11 +15,15 @@
 #include "ShaderProgram.h"
 #include <string>
 #include "Entity.h"
+#include "Animation.h"
+#include "GLState.h"
+#include "RenderStats.h"
 
 
 Entity::Entity()
 {
     position     = glm::vec3(0.0f);
+    previous_position = glm::vec3(0.0f);
     velocity     = glm::vec3(0.0f);
     acceleration = glm::vec3(0.0f);
     size = glm::vec3(1.0f);
@@ -39,15 +43,15 @@ Entity::~Entity()
     delete [] walking;
 }
 
-void Entity::draw_sprite_from_texture_atlas(ShaderProgram *program, GLuint texture_id, int index)
+void Entity::draw_sprite_from_texture_atlas(ShaderProgram *program, AtlasRegion region, int index)
 {
-    // Step 1: Calculate the UV location of the indexed frame
-    float u_coord = (float) (index % animation_cols) / (float) animation_cols;
-    float v_coord = (float) (index / animation_cols) / (float) animation_rows;
+    // Step 1: Calculate the UV size of one frame inside the region
+    float width = region.width / (float) animation_cols;
+    float height = region.height / (float) animation_rows;
     
-    // Step 2: Calculate its UV size
-    float width = 1.0f / (float) animation_cols;
-    float height = 1.0f / (float) animation_rows;
+    // Step 2: Calculate the UV location of the indexed frame
+    float u_coord = region.u + (float) (index % animation_cols) * width;
+    float v_coord = region.v + (float) (index / animation_cols) * height;
     
     // Step 3: Just as we have done before, match the texture coordinates to the vertices
     float tex_coords[] =
@@ -63,18 +67,16 @@ void Entity::draw_sprite_from_texture_atlas(ShaderProgram *program, GLuint textu
     };
     
     // Step 4: And render
-    glBindTexture(GL_TEXTURE_2D, texture_id);
+    GLState::bind_texture(region.texture_id);
     
+    // Client-side arrays need the array buffer unbound
+    GLState::bind_array_buffer(0);
     glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-    glEnableVertexAttribArray(program->positionAttribute);
-    
     glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, tex_coords);
-    glEnableVertexAttribArray(program->texCoordAttribute);
+    GLState::use_attributes({ (GLint) program->positionAttribute, (GLint) program->texCoordAttribute });
     
     glDrawArrays(GL_TRIANGLES, 0, 6);
-    
-    glDisableVertexAttribArray(program->positionAttribute);
-    glDisableVertexAttribArray(program->texCoordAttribute);
+    RenderStats::count_draw(6);
 }
 
 void Entity::activate_ai(Entity *player)
@@ -214,6 +216,7 @@ void Entity::item_collision(Entity *player){
 void Entity::update(float delta_time, Entity *player, Entity *objects, int object_count, Map *map)
 {
     open = false;
+    previous_position = position;
     if (!is_active) return;
     
     //ENEMY ONLY
@@ -240,23 +243,21 @@ void Entity::update(float delta_time, Entity *player, Entity *objects, int objec
         died = true;
     }
     
+    // The shader steps through the frames; here the clock is only started and stopped
     if (animation_indices != NULL)
     {
-        if (glm::length(movement) != 0)
+        bool moving = glm::length(movement) != 0;
+        
+        if (moving && animation_rate == 0.0f)
         {
-            animation_time += delta_time;
-            float frames_per_second = (float) 1 / SECONDS_PER_FRAME;
-            
-            if (animation_time >= frames_per_second)
-            {
-                animation_time = 0.0f;
-                animation_index++;
-                
-                if (animation_index >= animation_frames)
-                {
-                    animation_index = 0;
-                }
-            }
+            // One frame every 1 / SECONDS_PER_FRAME seconds, from the frame that was held
+            animation_time = Animation::now();
+            animation_rate = (float) SECONDS_PER_FRAME;
+        }
+        else if (!moving && animation_rate != 0.0f)
+        {
+            animation_index = get_animation_frame();
+            animation_rate = 0.0f;
         }
     }
     
@@ -289,10 +290,6 @@ void Entity::update(float delta_time, Entity *player, Entity *objects, int objec
         // STEP 2: The player now acquires an upward velocity
         velocity.y = jumping_power;
     }
-
-    model_matrix = glm::mat4(1.0f);
-    model_matrix = glm::translate(model_matrix, position);
-    model_matrix = glm::scale(model_matrix, size);
 }
 
 void const Entity::breakable_collision(Entity *player){
@@ -424,6 +421,12 @@ void const Entity::check_collision_y(Map *map)
         collided_top = true;
     }
     
+    // Headbutting a breakable tile knocks it out of the map; centre probe first
+    if (collided_top && entity_type == PLAYER)
+    {
+        if (!map->break_tile(top) && !map->break_tile(top_left)) map->break_tile(top_right);
+    }
+    
     if (map->is_solid(bottom, &penetration_x, &penetration_y) && velocity.y < 0)
     {
         position.y += penetration_y;
@@ -480,28 +483,83 @@ void Entity::render(ShaderProgram *program)
 {
     if (!is_active) return;
     
-    program->SetModelMatrix(model_matrix);
+    // Only this immediate path needs a matrix; batched sprites are placed by SpriteBatch
+    model_matrix = glm::mat4(1.0f);
+    model_matrix = glm::translate(model_matrix, position);
+    model_matrix = glm::scale(model_matrix, size);
+    GLState::set_model_matrix(program, model_matrix);
     
     if (animation_indices != NULL)
     {
-        draw_sprite_from_texture_atlas(program, texture_id, animation_indices[animation_index]);
+        draw_sprite_from_texture_atlas(program, texture_region, animation_indices[get_animation_frame()]);
         return;
     }
     
+    float left   = texture_region.u;
+    float right  = texture_region.u + texture_region.width;
+    float top    = texture_region.v;
+    float bottom = texture_region.v + texture_region.height;
+    
     float vertices[]   = { -0.5, -0.5, 0.5, -0.5, 0.5, 0.5, -0.5, -0.5, 0.5, 0.5, -0.5, 0.5 };
-    float tex_coords[] = {  0.0,  1.0, 1.0,  1.0, 1.0, 0.0,  0.0,  1.0, 1.0, 0.0,  0.0, 0.0 };
+    float tex_coords[] = { left, bottom, right, bottom, right, top, left, bottom, right, top, left, top };
     
-    glBindTexture(GL_TEXTURE_2D, texture_id);
+    GLState::bind_texture(texture_region.texture_id);
     
+    GLState::bind_array_buffer(0);
     glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-    glEnableVertexAttribArray(program->positionAttribute);
     glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, tex_coords);
-    glEnableVertexAttribArray(program->texCoordAttribute);
+    GLState::use_attributes({ (GLint) program->positionAttribute, (GLint) program->texCoordAttribute });
     
     glDrawArrays(GL_TRIANGLES, 0, 6);
+    RenderStats::count_draw(6);
+}
+
+void Entity::render(RenderQueue *queue, ShaderProgram *program, Visibility *visibility, RenderLayer layer)
+{
+    if (!is_active) return;
+    
+    // The glow can reach the screen before the sprite does
+    if (light_radius > 0.0f && (visibility == NULL || visibility->contains(position, glm::vec3(2.0f * light_radius))))
+    {
+        queue->submit_light(position, previous_position, light_radius, light_color, light_intensity);
+    }
+    
+    if (visibility != NULL && !visibility->test(position, size)) return;
+    
+    if (animation_indices == NULL)
+    {
+        queue->submit_sprite(layer, program, texture_region.texture_id, position, previous_position, size, texture_region.u, texture_region.v, texture_region.width, texture_region.height);
+        return;
+    }
     
-    glDisableVertexAttribArray(program->positionAttribute);
-    glDisableVertexAttribArray(program->texCoordAttribute);
+    // Only a change of direction costs a lookup; the frames themselves are the shader's
+    if (animation_indices != animation_clip_indices)
+    {
+        animation_clip = Animation::add_clip(texture_region, animation_cols, animation_rows, animation_indices, animation_frames);
+        animation_clip_indices = animation_indices;
+    }
+    
+    // No room in the shader's tables: pick the frame here, as the direct path does, and draw it still
+    if (animation_clip == 0)
+    {
+        int index = animation_indices[get_animation_frame()];
+        float width = texture_region.width / (float) animation_cols;
+        float height = texture_region.height / (float) animation_rows;
+        
+        queue->submit_sprite(layer, program, texture_region.texture_id, position, previous_position, size,
+                             texture_region.u + (float) (index % animation_cols) * width,
+                             texture_region.v + (float) (index / animation_cols) * height, width, height);
+        return;
+    }
+    
+    // A unit UV rectangle, which the clip's frame places in the atlas
+    glm::vec4 animation((float) animation_clip, animation_rate, animation_time, (float) animation_index);
+    queue->submit_sprite(layer, program, texture_region.texture_id, position, previous_position, size, 0.0f, 0.0f, 1.0f, 1.0f, glm::vec4(1.0f), animation);
+}
+
+int Entity::get_animation_frame() const
+{
+    return Animation::frame_at(Animation::now(), animation_frames, animation_time, animation_rate, animation_index);
 }
 
 bool const Entity::check_collision(Entity *other) const
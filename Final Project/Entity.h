@@ -1,5 +1,8 @@
 #pragma once
 #include "Map.h"
+#include "SpriteBatch.h"
+#include "RenderQueue.h"
+#include "TextureAtlas.h"
 
 enum EntityType { PLATFORM, PLAYER, ENEMY, BREAKABLE, JUMPER, WEAPON, ITEM};
 enum AIType     { WALKER, GUARD, ATTACKER, FLYER};
@@ -18,7 +21,12 @@ private:
     int *animation_up    = NULL; // move upwards
     int *animation_down  = NULL; // move downwards
     
+    // The Animation clip made from animation_indices, remade only when they change
+    int *animation_clip_indices = NULL;
+    int animation_clip = 0;
+    
     glm::vec3 position;
+    glm::vec3 previous_position; // where the last fixed step started, for render interpolation
     glm::vec3 velocity;
     glm::vec3 size;
     
@@ -35,7 +43,7 @@ public:
                      DOWN  = 3;
     
     // Existing
-    GLuint texture_id;
+    AtlasRegion texture_region;
     glm::mat4 model_matrix;
     EntityType type;
     
@@ -45,15 +53,23 @@ public:
     glm::vec3 movement;
     glm::vec3 acceleration;
     
-    // Animating
+    // Animating. The shader picks the frame: animation_index is the frame the
+    // clip started on, animation_time when (on the Animation clock) and
+    // animation_rate how fast it runs, 0 while the frame is held
     int **walking          = new int*[4] { animation_left, animation_right, animation_up, animation_down };
     int *animation_indices = NULL;
     int animation_frames   = 0;
     int animation_index    = 0;
     float animation_time   = 0.0f;
+    float animation_rate   = 0.0f;
     int animation_cols     = 0;
     int animation_rows     = 0;
     
+    // Glowing; a radius of 0 casts no light
+    float light_radius     = 0.0f;
+    float light_intensity  = 1.0f;
+    glm::vec3 light_color  = glm::vec3(1.0f);
+    
     // Jumping
     bool is_jumping     = false;
     float jumping_power = 0;
@@ -79,9 +95,11 @@ public:
     Entity();
     ~Entity();
 
-    void draw_sprite_from_texture_atlas(ShaderProgram *program, GLuint texture_id, int index);
+    void draw_sprite_from_texture_atlas(ShaderProgram *program, AtlasRegion region, int index);
+    int get_animation_frame() const;
     void update(float delta_time, Entity *player, Entity *object, int object_count, Map *map);
     void render(ShaderProgram *program);
+    void render(RenderQueue *queue, ShaderProgram *program, Visibility *visibility = NULL, RenderLayer layer = LAYER_ENTITIES);
     void activate_ai(Entity *player);
     void ai_walker();
     void ai_guard(Entity *player);
@@ -111,6 +129,7 @@ public:
     AIType    const get_ai_type()      const { return ai_type;      };
     AIState   const get_ai_state()     const { return ai_state;     };
     glm::vec3 const get_position()     const { return position;     };
+    glm::vec3 const get_previous_position() const { return previous_position; };
     glm::vec3 const get_movement()     const { return movement;     };
     glm::vec3 const get_velocity()     const { return velocity;     };
     glm::vec3 const get_acceleration() const { return acceleration; };
@@ -121,7 +140,8 @@ public:
     void const set_entity_type(EntityType new_entity_type)  { entity_type = new_entity_type;   };
     void const set_ai_type(AIType new_ai_type)              { ai_type = new_ai_type;           };
     void const set_ai_state(AIState new_state)              { ai_state = new_state;            };
-    void const set_position(glm::vec3 new_position)         { position = new_position;         };
+    // Placing an entity is a teleport, so it is never interpolated across
+    void const set_position(glm::vec3 new_position)         { position = new_position; previous_position = new_position; };
     void const set_movement(glm::vec3 new_movement)         { movement = new_movement;         };
     void const set_velocity(glm::vec3 new_velocity)         { velocity = new_velocity;         };
     void const set_size(glm::vec3 new_size)                 { size = new_size;               };
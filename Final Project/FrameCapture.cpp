@@ -0,0 +1,329 @@
+#include "FrameCapture.h"
+#include "Utility.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+FrameCapture::FrameCapture(int width, int height, CaptureFormat format)
+{
+    this->width = width;
+    this->height = height;
+    this->format = format;
+    
+    SDL_DisplayMode mode;
+    if (SDL_GetCurrentDisplayMode(0, &mode) == 0 && mode.refresh_rate > 0) this->display_millihertz = mode.refresh_rate * 1000;
+
+#ifdef GL_SYNC_GPU_COMMANDS_COMPLETE
+    // Core in 3.2; older contexts may still have the extension
+    const char *version = (const char *) glGetString(GL_VERSION);
+    const char *extensions = (const char *) glGetString(GL_EXTENSIONS);
+    this->has_fences = (version != NULL && (version[0] > '3' || (version[0] == '3' && version[2] >= '2'))) ||
+                       (extensions != NULL && strstr(extensions, "GL_ARB_sync") != NULL);
+#ifdef _WINDOWS
+    if (glFenceSync == NULL || glClientWaitSync == NULL) this->has_fences = false;
+#endif
+#endif
+
+    // Pack buffers are only ever bound here, so GLState doesn't track them
+    for (Slot &slot : this->slots)
+    {
+        glGenBuffers(1, &slot.buffer_id);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer_id);
+        glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 4, NULL, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    this->worker = std::thread(&FrameCapture::work, this);
+}
+
+FrameCapture::~FrameCapture()
+{
+    this->set_recording(false);
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->wake.notify_one();
+    this->worker.join();
+
+    for (Slot &slot : this->slots) glDeleteBuffers(1, &slot.buffer_id);
+}
+
+void FrameCapture::set_recording(bool recording)
+{
+    if (recording == this->recording) return;
+
+    if (recording)
+    {
+        this->recording_count++;
+        this->frame_count = 0;
+        this->dropped_count = 0;
+        this->recording = true;
+        return;
+    }
+
+    // Everything already read back still belongs to this recording
+    this->collect(true);
+    this->recording = false;
+
+    Job job;
+    job.recording = this->recording_count;
+    job.frame = this->frame_count;
+    job.captured_at = 0;
+    job.finish = true;
+    this->push(job);
+
+    if (this->dropped_count > 0) LOG("Capture dropped " << this->dropped_count << " frames; the disk could not keep up.");
+}
+
+bool FrameCapture::slot_ready(const Slot &slot) const
+{
+#ifdef GL_SYNC_GPU_COMMANDS_COMPLETE
+    if (this->has_fences)
+    {
+        GLenum status = glClientWaitSync(slot.fence, 0, 0);
+        return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+    }
+#endif
+
+    // No fences: by now the driver has had a couple of swaps to finish the copy
+    return this->frame_count - slot.frame >= RING_SIZE - 1;
+}
+
+void FrameCapture::collect(bool wait)
+{
+    // Oldest first, so frames reach the worker in order
+    while (this->slots[this->oldest_slot].pending)
+    {
+        Slot &slot = this->slots[this->oldest_slot];
+
+        if (!wait && !this->slot_ready(slot)) return;
+
+#ifdef GL_SYNC_GPU_COMMANDS_COMPLETE
+        if (this->has_fences)
+        {
+            if (wait) glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            glDeleteSync(slot.fence);
+            slot.fence = 0;
+        }
+#endif
+
+        // STEP 1: A buffer to copy into, reused from the pool when the worker has handed one back
+        Job job;
+        job.recording = this->recording_count;
+        job.frame = slot.frame;
+        job.captured_at = slot.captured_at;
+        job.finish = false;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (!this->spare_buffers.empty())
+            {
+                job.pixels.swap(this->spare_buffers.back());
+                this->spare_buffers.pop_back();
+            }
+        }
+        job.pixels.resize(this->width * this->height * 4);
+
+        // STEP 2: The copy finished long ago, so mapping doesn't wait on the GPU
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer_id);
+        const unsigned char *pixels = (const unsigned char *) glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+        if (pixels != NULL)
+        {
+            memcpy(job.pixels.data(), pixels, job.pixels.size());
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            this->push(job);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        slot.pending = false;
+        this->oldest_slot = (this->oldest_slot + 1) % RING_SIZE;
+    }
+}
+
+void FrameCapture::push(Job &job)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        // A full queue means the disk is behind; drop the frame rather than wait for it
+        if (!job.finish && (int) this->jobs.size() >= MAX_QUEUED_FRAMES)
+        {
+            this->dropped_count++;
+            this->spare_buffers.push_back(std::move(job.pixels));
+            return;
+        }
+
+        this->jobs.push_back(std::move(job));
+    }
+    this->wake.notify_one();
+}
+
+void FrameCapture::capture_frame()
+{
+    if (!this->recording) return;
+
+    // STEP 1: Hand over whatever has finished copying
+    this->collect(false);
+
+    // STEP 2: If the ring has gone all the way round, the oldest frame has to come out first
+    Slot &slot = this->slots[this->next_slot];
+    if (slot.pending) this->collect(true);
+
+    // STEP 3: Start this frame's copy; with a pack buffer bound it returns straight away
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer_id);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, this->width, this->height, GL_RGBA, GL_UNSIGNED_BYTE, (void *) 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+#ifdef GL_SYNC_GPU_COMMANDS_COMPLETE
+    if (this->has_fences) slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+
+    slot.pending = true;
+    slot.frame = this->frame_count++;
+    slot.captured_at = SDL_GetPerformanceCounter();
+    this->next_slot = (this->next_slot + 1) % RING_SIZE;
+}
+
+void FrameCapture::work()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->wake.wait(lock, [this]() { return this->stopping || !this->jobs.empty(); });
+
+            if (this->jobs.empty()) return;
+            job = std::move(this->jobs.front());
+            this->jobs.pop_front();
+        }
+
+        this->write_frame(job);
+
+        if (!job.finish)
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->spare_buffers.push_back(std::move(job.pixels));
+        }
+    }
+}
+
+void FrameCapture::write_frame(const Job &job)
+{
+    char filepath[64];
+
+    if (job.finish)
+    {
+        // Frames that made it to the file over the time they span, so it plays back in real time
+        if (this->file != NULL && this->frames_written > 1 && this->last_captured_at > this->first_captured_at)
+        {
+            double seconds = (double) (this->last_captured_at - this->first_captured_at) / (double) SDL_GetPerformanceFrequency();
+            fseek(this->file, 0, SEEK_SET);
+            this->write_y4m_header((int) ((this->frames_written - 1) * 1000.0 / seconds + 0.5));
+        }
+        
+        if (this->file != NULL) fclose(this->file);
+        this->file = NULL;
+        this->frames_written = 0;
+
+        LOG("Captured " << job.frame << " frames into recording " << job.recording << ".");
+        return;
+    }
+
+    if (this->format == CAPTURE_PPM)
+    {
+        snprintf(filepath, sizeof(filepath), "capture_%02d_%05d.ppm", job.recording, job.frame);
+        FILE *file = fopen(filepath, "wb");
+        if (file == NULL) return;
+
+        // GL's rows start at the bottom; PPM's at the top
+        fprintf(file, "P6\n%d %d\n255\n", this->width, this->height);
+        for (int y = this->height - 1; y >= 0; y--)
+        {
+            const unsigned char *row = &job.pixels[y * this->width * 4];
+            for (int x = 0; x < this->width; x++) fwrite(row + x * 4, 1, 3, file);
+        }
+        fclose(file);
+        return;
+    }
+
+    // One Y4M file per recording, opened on its first frame
+    if (this->file == NULL)
+    {
+        snprintf(filepath, sizeof(filepath), "capture_%02d.y4m", job.recording);
+        this->file = fopen(filepath, "wb");
+        if (this->file == NULL)
+        {
+            LOG("Unable to write " << filepath << ".");
+            return;
+        }
+
+        this->write_y4m_header(this->display_millihertz);
+    }
+
+    if (this->frames_written == 0) this->first_captured_at = job.captured_at;
+    this->last_captured_at = job.captured_at;
+    this->frames_written++;
+
+    this->write_y4m_frame(job.pixels);
+}
+
+void FrameCapture::write_y4m_header(int millihertz)
+{
+    // Fixed width, so finishing a recording can overwrite it in place. The planes
+    // are full-range BT.601, which readers assume is limited range unless told
+    millihertz = std::min(std::max(millihertz, 1), 9999999);
+    fprintf(this->file, "YUV4MPEG2 W%d H%d F%07d:1000 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n", this->width, this->height, millihertz);
+}
+
+void FrameCapture::write_y4m_frame(const std::vector<unsigned char> &pixels)
+{
+    if (this->file == NULL) return;
+
+    int chroma_width = (this->width + 1) / 2, chroma_height = (this->height + 1) / 2;
+    int luma_size = this->width * this->height, chroma_size = chroma_width * chroma_height;
+    this->planes.resize(luma_size + 2 * chroma_size);
+
+    unsigned char *y_plane = this->planes.data();
+    unsigned char *u_plane = y_plane + luma_size;
+    unsigned char *v_plane = u_plane + chroma_size;
+
+    // STEP 1: Full-range BT.601 luma per pixel, flipped so the top row comes first
+    for (int y = 0; y < this->height; y++)
+    {
+        const unsigned char *row = &pixels[(this->height - 1 - y) * this->width * 4];
+        for (int x = 0; x < this->width; x++)
+        {
+            const unsigned char *p = row + x * 4;
+            y_plane[y * this->width + x] = (unsigned char) ((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+        }
+    }
+
+    // STEP 2: Chroma from the average of each 2x2 block
+    for (int y = 0; y < chroma_height; y++)
+    {
+        for (int x = 0; x < chroma_width; x++)
+        {
+            int r = 0, g = 0, b = 0, samples = 0;
+            for (int dy = 0; dy < 2 && 2 * y + dy < this->height; dy++)
+            {
+                const unsigned char *row = &pixels[(this->height - 1 - (2 * y + dy)) * this->width * 4];
+                for (int dx = 0; dx < 2 && 2 * x + dx < this->width; dx++)
+                {
+                    const unsigned char *p = row + (2 * x + dx) * 4;
+                    r += p[0]; g += p[1]; b += p[2];
+                    samples++;
+                }
+            }
+            r /= samples; g /= samples; b /= samples;
+
+            u_plane[y * chroma_width + x] = (unsigned char) std::min(std::max((-43 * r - 85 * g + 128 * b + 128) / 256 + 128, 0), 255);
+            v_plane[y * chroma_width + x] = (unsigned char) std::min(std::max((128 * r - 107 * g - 21 * b + 128) / 256 + 128, 0), 255);
+        }
+    }
+
+    fputs("FRAME\n", this->file);
+    fwrite(this->planes.data(), 1, this->planes.size(), this->file);
+}
@@ -0,0 +1,109 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <SDL.h>
+#include <SDL_opengl.h>
+
+enum CaptureFormat { CAPTURE_Y4M, CAPTURE_PPM };
+
+/**
+ Records what the window shows without stalling the render thread. Each
+ frame is read back into the next of a ring of pixel pack buffers, which
+ returns at once; a buffer is only mapped a couple of frames later, once
+ its fence says the copy is done (or, without sync objects, once it is
+ RING_SIZE - 1 frames old). The pixels are then handed to a worker thread
+ that writes them to disk as one Y4M video per recording or as a numbered
+ PPM sequence. If the disk falls behind, frames are dropped, not waited for.
+ Everything but the worker runs on the thread that owns the context.
+ */
+class FrameCapture {
+private:
+    static const int RING_SIZE = 3;
+    // Frames waiting for the worker before new ones are dropped
+    static const int MAX_QUEUED_FRAMES = 8;
+
+    struct Slot
+    {
+        GLuint buffer_id = 0;
+#ifdef GL_SYNC_GPU_COMMANDS_COMPLETE
+        GLsync fence = 0;
+#endif
+        bool pending = false;
+        int frame = 0;
+        Uint64 captured_at = 0;
+    };
+
+    // What the worker is asked to do: write a frame, or finish a recording
+    struct Job
+    {
+        std::vector<unsigned char> pixels;
+        int recording, frame;
+        Uint64 captured_at;
+        bool finish;
+    };
+
+    int width, height;
+    CaptureFormat format;
+    bool has_fences = false;
+
+    Slot slots[RING_SIZE];
+    int next_slot = 0;    // where the next frame is read into
+    int oldest_slot = 0;  // where the next finished frame comes out
+
+    bool recording = false;
+    int recording_count = 0;
+    int frame_count = 0;
+    int dropped_count = 0;
+
+    // Worker: the queue and a pool of frame-sized buffers, so recording allocates nothing after a few frames
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Job> jobs;
+    std::vector<std::vector<unsigned char>> spare_buffers;
+    bool stopping = false;
+
+    // Worker-side output
+    FILE *file = NULL;
+    std::vector<unsigned char> planes;
+    
+    // Frames are captured once per draw, which follows the display, not a fixed
+    // 60 Hz. A Y4M header starts out with the display's refresh rate and is
+    // rewritten with the rate actually recorded when the recording finishes
+    int display_millihertz = 60000;
+    int frames_written = 0;
+    Uint64 first_captured_at = 0, last_captured_at = 0;
+
+    bool slot_ready(const Slot &slot) const;
+    void collect(bool wait);
+    void push(Job &job);
+
+    void work();
+    void write_frame(const Job &job);
+    void write_y4m_header(int millihertz);
+    void write_y4m_frame(const std::vector<unsigned char> &pixels);
+
+public:
+    FrameCapture(int width, int height, CaptureFormat format);
+    ~FrameCapture();
+
+    // Starting opens a new recording; stopping waits for the frames still in flight
+    void set_recording(bool recording);
+
+    // Once per frame, after everything is drawn and before the swap
+    void capture_frame();
+
+    bool const is_recording()      const { return this->recording;     }
+    int  const get_dropped_count() const { return this->dropped_count; }
+};
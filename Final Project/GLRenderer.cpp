@@ -0,0 +1,109 @@
+#define LEVEL_OF_DETAIL 0    // base image level; Level n is the nth mipmap reduction image
+#define TEXTURE_BORDER 0     // this value MUST be zero
+
+#include "GLRenderer.h"
+#include "GLState.h"
+#include "Map.h"
+#include "StaticLayer.h"
+#include "Utility.h"
+#include <algorithm>
+
+GLRenderer::GLRenderer(ShaderProgram *program, int width, int height)
+{
+    this->program = program;
+    this->width = width;
+    this->height = height;
+}
+
+GLRenderer::~GLRenderer()
+{
+    for (GLuint &texture_id : this->textures) GLState::delete_texture(texture_id);
+}
+
+GLuint GLRenderer::create_texture(int width, int height, const unsigned char *pixels)
+{
+    GLuint texture_id;
+    glGenTextures(1, &texture_id);
+    GLState::bind_texture(texture_id);
+    glTexImage2D(GL_TEXTURE_2D, LEVEL_OF_DETAIL, GL_RGBA, width, height, TEXTURE_BORDER, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    this->textures.push_back(texture_id);
+    return texture_id;
+}
+
+void GLRenderer::delete_texture(GLuint texture_id)
+{
+    auto texture = std::find(this->textures.begin(), this->textures.end(), texture_id);
+    if (texture == this->textures.end()) return;
+
+    GLState::delete_texture(*texture);
+    this->textures.erase(texture);
+}
+
+void GLRenderer::begin_frame(const glm::mat4 &view_matrix, const glm::mat4 &projection_matrix, glm::vec4 clear_color)
+{
+    GLState::set_projection_matrix(this->program, projection_matrix);
+    GLState::set_view_matrix(this->program, view_matrix);
+
+    glViewport(0, 0, this->width, this->height);
+    glClearColor(clear_color.r, clear_color.g, clear_color.b, clear_color.a);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void GLRenderer::draw_sprites(const SpriteBatch::Sprite *sprites, int count)
+{
+    this->batch.begin();
+    for (int i = 0; i < count; i++)
+    {
+        const SpriteBatch::Sprite &sprite = sprites[i];
+        this->batch.submit(sprite.texture_id, sprite.position, sprite.size, sprite.u, sprite.v, sprite.width, sprite.height, sprite.color, sprite.animation);
+    }
+    this->batch.flush(this->program);
+}
+
+void GLRenderer::draw_map(Map *map, Visibility *visibility)
+{
+    map->render(this->program, visibility);
+}
+
+void GLRenderer::draw_text(GLuint font_texture_id, const std::string &text, float screen_size, float spacing, glm::vec3 position)
+{
+    Utility::draw_text(this->program, font_texture_id, text, screen_size, spacing, position);
+}
+
+void GLRenderer::update_static_layer(StaticLayer *static_layer)
+{
+    static_layer->update(this, this->program);
+}
+
+void GLRenderer::draw_static_layer(StaticLayer *static_layer, const Visibility *visibility)
+{
+    static_layer->render(this, visibility);
+}
+
+void GLRenderer::end_frame()
+{
+    // Draw calls only queue work; wait for it so the frame can be timed
+    glFinish();
+}
+
+void GLRenderer::read_pixels(std::vector<unsigned char> &pixels)
+{
+    int row_size = this->width * 4;
+    pixels.resize(row_size * this->height);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, this->width, this->height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    // GL's first row is the bottom one
+    for (int y = 0; y < this->height / 2; y++)
+    {
+        std::swap_ranges(pixels.begin() + y * row_size, pixels.begin() + (y + 1) * row_size,
+                         pixels.begin() + (this->height - 1 - y) * row_size);
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "Renderer.h"
+#include "ShaderProgram.h"
+#include "SpriteBatch.h"
+
+/**
+ Renderer over the game's GL path: textures go up the way Utility and the
+ atlas upload them and quads go through a SpriteBatch with the uber-shader,
+ drawing into whatever framebuffer is bound. Maps, text and static layers
+ take the game's own GL paths. The game flushes its queue through one of
+ these between its own begin and end of frame, so begin_frame() and
+ end_frame() are only for the benchmark.
+ */
+class GLRenderer : public Renderer {
+private:
+    ShaderProgram *program;
+    SpriteBatch batch;
+    std::vector<GLuint> textures;
+
+    int width, height;
+
+public:
+    GLRenderer(ShaderProgram *program, int width, int height);
+    ~GLRenderer();
+
+    GLuint create_texture(int width, int height, const unsigned char *pixels) override;
+    void delete_texture(GLuint texture_id) override;
+
+    void begin_frame(const glm::mat4 &view_matrix, const glm::mat4 &projection_matrix, glm::vec4 clear_color) override;
+    void draw_sprites(const SpriteBatch::Sprite *sprites, int count) override;
+
+    void draw_map(Map *map, Visibility *visibility) override;
+    void draw_text(GLuint font_texture_id, const std::string &text, float screen_size, float spacing, glm::vec3 position) override;
+    void update_static_layer(StaticLayer *static_layer) override;
+    void draw_static_layer(StaticLayer *static_layer, const Visibility *visibility) override;
+    void end_frame() override;
+
+    void read_pixels(std::vector<unsigned char> &pixels) override;
+
+    int get_width() const override  { return this->width;  }
+    int get_height() const override { return this->height; }
+    const char *get_name() const override { return "gl"; }
+};
@@ -0,0 +1,158 @@
+#include "GLState.h"
+#include "RenderStats.h"
+
+GLuint GLState::current_program = GLState::UNKNOWN;
+GLuint GLState::current_texture = GLState::UNKNOWN;
+GLuint GLState::current_array_buffer = GLState::UNKNOWN;
+GLuint GLState::current_element_buffer = GLState::UNKNOWN;
+unsigned int GLState::enabled_attributes = 0;
+unsigned int GLState::defaulted_attributes = 0;
+glm::vec4 GLState::attribute_defaults[GLState::MAX_TRACKED_ATTRIBUTES];
+std::map<GLuint, GLState::ProgramUniforms> GLState::uniforms;
+
+int GLState::calls_issued = 0;
+int GLState::calls_elided = 0;
+
+bool GLState::count(bool changed)
+{
+    if (changed) calls_issued++;
+    else         calls_elided++;
+
+    return changed;
+}
+
+void GLState::use_program(GLuint program_id)
+{
+    if (!count(program_id != current_program)) return;
+
+    glUseProgram(program_id);
+    current_program = program_id;
+    RenderStats::count_program_switch();
+}
+
+void GLState::bind_texture(GLuint texture_id)
+{
+    if (!count(texture_id != current_texture)) return;
+
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    current_texture = texture_id;
+    RenderStats::count_texture_bind();
+}
+
+void GLState::bind_array_buffer(GLuint buffer_id)
+{
+    if (!count(buffer_id != current_array_buffer)) return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_id);
+    current_array_buffer = buffer_id;
+}
+
+void GLState::bind_element_buffer(GLuint buffer_id)
+{
+    if (!count(buffer_id != current_element_buffer)) return;
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer_id);
+    current_element_buffer = buffer_id;
+}
+
+void GLState::use_attributes(std::initializer_list<GLint> attributes)
+{
+    // Enable exactly these arrays; anything left on from another draw is switched off
+    unsigned int wanted = 0;
+    for (GLint attribute : attributes)
+    {
+        if (attribute >= 0 && attribute < MAX_TRACKED_ATTRIBUTES) wanted |= 1u << attribute;
+    }
+
+    for (int attribute = 0; attribute < MAX_TRACKED_ATTRIBUTES; attribute++)
+    {
+        unsigned int bit = 1u << attribute;
+        bool is_wanted = (wanted & bit) != 0;
+        bool is_enabled = (enabled_attributes & bit) != 0;
+
+        if (!is_wanted && !is_enabled) continue;
+
+        if (!count(is_wanted != is_enabled)) continue;
+
+        if (is_wanted) glEnableVertexAttribArray(attribute);
+        else           glDisableVertexAttribArray(attribute);
+
+        if (!is_wanted && (defaulted_attributes & bit) != 0) glVertexAttrib4fv(attribute, &attribute_defaults[attribute][0]);
+    }
+
+    enabled_attributes = wanted;
+}
+
+void GLState::set_attribute_default(GLint attribute, const glm::vec4 &value)
+{
+    if (attribute < 0 || attribute >= MAX_TRACKED_ATTRIBUTES) return;
+
+    unsigned int bit = 1u << attribute;
+    defaulted_attributes |= bit;
+    attribute_defaults[attribute] = value;
+
+    // Takes effect now unless the array is in use, in which case it will on disable
+    if ((enabled_attributes & bit) == 0) glVertexAttrib4fv(attribute, &value[0]);
+}
+
+void GLState::set_matrix(ShaderProgram *program, GLuint uniform, bool &has_value, glm::mat4 &cached, const glm::mat4 &matrix)
+{
+    if (!count(!has_value || cached != matrix)) return;
+
+    use_program(program->programID);
+    glUniformMatrix4fv(uniform, 1, GL_FALSE, &matrix[0][0]);
+
+    has_value = true;
+    cached = matrix;
+}
+
+void GLState::set_model_matrix(ShaderProgram *program, const glm::mat4 &matrix)
+{
+    ProgramUniforms &cache = uniforms[program->programID];
+    set_matrix(program, program->modelMatrixUniform, cache.has_model, cache.model, matrix);
+}
+
+void GLState::set_view_matrix(ShaderProgram *program, const glm::mat4 &matrix)
+{
+    ProgramUniforms &cache = uniforms[program->programID];
+    set_matrix(program, program->viewMatrixUniform, cache.has_view, cache.view, matrix);
+}
+
+void GLState::set_projection_matrix(ShaderProgram *program, const glm::mat4 &matrix)
+{
+    ProgramUniforms &cache = uniforms[program->programID];
+    set_matrix(program, program->projectionMatrixUniform, cache.has_projection, cache.projection, matrix);
+}
+
+void GLState::set_color(ShaderProgram *program, float r, float g, float b, float a)
+{
+    ProgramUniforms &cache = uniforms[program->programID];
+    glm::vec4 color = glm::vec4(r, g, b, a);
+
+    if (!count(!cache.has_color || cache.color != color)) return;
+
+    use_program(program->programID);
+    glUniform4f(program->colorUniform, r, g, b, a);
+
+    cache.has_color = true;
+    cache.color = color;
+}
+
+void GLState::delete_buffer(GLuint &buffer_id)
+{
+    if (buffer_id == 0) return;
+    if (buffer_id == current_array_buffer) current_array_buffer = 0;
+    if (buffer_id == current_element_buffer) current_element_buffer = 0;
+
+    glDeleteBuffers(1, &buffer_id);
+    buffer_id = 0;
+}
+
+void GLState::delete_texture(GLuint &texture_id)
+{
+    if (texture_id == 0) return;
+    if (texture_id == current_texture) current_texture = 0;
+
+    glDeleteTextures(1, &texture_id);
+    texture_id = 0;
+}
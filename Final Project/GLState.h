@@ -0,0 +1,76 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <initializer_list>
+#include <map>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "glm/vec4.hpp"
+#include "ShaderProgram.h"
+
+/**
+ Remembers the GL state we last set and drops calls that would not change it.
+ Every draw path goes through here instead of calling glUseProgram,
+ glBindTexture, glBindBuffer, glEnableVertexAttribArray or the ShaderProgram
+ setters (which each call glUseProgram) directly.
+ */
+class GLState {
+private:
+    static const GLuint UNKNOWN = ~0u;
+    static const int MAX_TRACKED_ATTRIBUTES = 32;
+
+    struct ProgramUniforms
+    {
+        bool has_model = false, has_view = false, has_projection = false, has_color = false;
+        glm::mat4 model, view, projection;
+        glm::vec4 color;
+    };
+
+    static GLuint current_program;
+    static GLuint current_texture;
+    static GLuint current_array_buffer;
+    static GLuint current_element_buffer;
+    static unsigned int enabled_attributes;
+
+    // Values an attribute reads while its array is off. A draw with the array
+    // on leaves the current value undefined, so it is put back on every disable
+    static unsigned int defaulted_attributes;
+    static glm::vec4 attribute_defaults[MAX_TRACKED_ATTRIBUTES];
+    static std::map<GLuint, ProgramUniforms> uniforms;
+
+    static bool count(bool changed);
+    static void set_matrix(ShaderProgram *program, GLuint uniform, bool &has_value, glm::mat4 &cached, const glm::mat4 &matrix);
+
+public:
+    // Driver calls that went through vs. ones that were skipped as redundant
+    static int calls_issued;
+    static int calls_elided;
+
+    static void use_program(GLuint program_id);
+    static void bind_texture(GLuint texture_id);
+    static void bind_array_buffer(GLuint buffer_id);
+    static void bind_element_buffer(GLuint buffer_id);
+    static void use_attributes(std::initializer_list<GLint> attributes);
+    static void set_attribute_default(GLint attribute, const glm::vec4 &value);
+
+    static void set_model_matrix(ShaderProgram *program, const glm::mat4 &matrix);
+    static void set_view_matrix(ShaderProgram *program, const glm::mat4 &matrix);
+    static void set_projection_matrix(ShaderProgram *program, const glm::mat4 &matrix);
+    static void set_color(ShaderProgram *program, float r, float g, float b, float a);
+
+    // What the program's matrices were last set to, so a detour through another view can put them back
+    static glm::mat4 get_view_matrix(ShaderProgram *program)       { return uniforms[program->programID].view;       }
+    static glm::mat4 get_projection_matrix(ShaderProgram *program) { return uniforms[program->programID].projection; }
+
+    // Deleting a bound object silently rebinds 0, so deletes go through here too
+    static void delete_buffer(GLuint &buffer_id);
+    static void delete_texture(GLuint &texture_id);
+
+    static void reset_counters() { calls_issued = 0; calls_elided = 0; }
+};
@@ -9,6 +9,9 @@ const float BG_RED     = 1.0f,
             BG_GREEN   = 0.34f,
             BG_OPACITY = 1.0f;
 
+// Built once so drawing the title never allocates
+const std::string TITLE_TEXT = "ADVENTURE OF LAVABOY";
+
 unsigned int Intro_DATA[] =
 {
 };
@@ -26,8 +29,9 @@ void Intro::initialise()
 {
     state.next_scene_id = -1;
     
-    GLuint map_texture_id = Utility::load_texture("assets/texture/tileset.png");
-    this->state.map = new Map(LEVEL_WIDTH, LEVEL_HEIGHT, Intro_DATA, map_texture_id, 1.0f, 4, 1);
+    this->state.map = new Map(LEVEL_WIDTH, LEVEL_HEIGHT, 1.0f);
+    this->state.map->add_layer(Intro_DATA, "assets/texture/tileset.png", 4, 1);
+    this->state.map->build();
     
     state.font_texture_id = Utility::load_texture("assets/texture/font1.png");
     
@@ -42,7 +46,7 @@ void Intro::initialise()
     state.player->set_movement(glm::vec3(0.0f));
     state.player->speed = 3.5f;
     state.player->set_acceleration(glm::vec3(0.0f, -5.81f, 0.0f));
-    state.player->texture_id = Utility::load_texture("assets/texture/fireboy.png");
+    state.player->texture_region = Utility::load_texture("assets/texture/fireboy.png");
     
     // Walking
     state.player->walking[state.player->LEFT]  = new int[4] { 1, 5, 9,  13 };
@@ -66,7 +70,7 @@ void Intro::initialise()
     state.player->deactivate();
     
     state.background = new Entity();
-    state.background->texture_id = Utility::load_texture("assets/texture/background1.jpg");
+    state.background->texture_region = Utility::load_texture("assets/texture/background1.jpg");
     state.background->set_position(glm::vec3(6.0f, -3.7f, -1.0f));
     state.background->set_size(glm::vec3(18.0f, 8.0f, 1.0f));
     
@@ -90,8 +94,8 @@ void Intro::update(float delta_time)
 
 void Intro::render(ShaderProgram *program)
 {
-    this->state.background->render(program);
-    Utility::draw_text(program, this->state.font_texture_id, "ADVENTURE OF LAVABOY", 0.5f, 0.25f, glm::vec3(3.0f, -2.0f, 0.0f));
-    this->state.map->render(program);
-    this->state.player->render(program);
+    this->state.background->render(&this->render_queue, program, &this->visibility, LAYER_BACKGROUND);
+    this->render_queue.submit_text(program, this->state.font_texture_id, TITLE_TEXT, 0.5f, 0.25f, glm::vec3(3.0f, -2.0f, 0.0f));
+    this->render_queue.submit_map(program, this->state.map, &this->visibility);
+    this->state.player->render(&this->render_queue, program, &this->visibility);
 }
@@ -7,6 +7,8 @@
 #define LEVEL1_LEFT_EDGE 5.0f
 #define LOG(argument) std::cout << argument << '\n'
 
+const std::string FAILED_TEXT = "MISSION FAILED!";
+
 glm::vec3 view_position;
 
 unsigned int LEVELA_DATA[] =
@@ -15,7 +17,7 @@ unsigned int LEVELA_DATA[] =
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
     1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1
@@ -27,6 +29,7 @@ LevelA::~LevelA()
     delete [] this->state.breakable;
     delete    this->state.player;
     delete    this->state.map;
+    delete    this->state.atlas;
     delete [] this->state.jumper;
     delete    this->state.weapon;
     delete    this->state.background;
@@ -40,11 +43,27 @@ void LevelA::initialise()
     state.mission_failed = false;
     view_position = glm::vec3(0.0f);
     
-    GLuint map_texture_id = Utility::load_texture("assets/texture/tileset.png");
-    this->state.map = new Map(LEVEL_WIDTH, LEVEL_HEIGHT, LEVELA_DATA, map_texture_id, 1.0f, 4, 1);
+    // The same tileset with the breakable block appended as tile 4
+    this->state.map = new Map(LEVEL_WIDTH, LEVEL_HEIGHT, 1.0f);
+    this->state.map->add_layer(LEVELA_DATA, "assets/texture/tileset_breakable.png", 5, 1);
+    this->state.map->set_breakable(4);
+    this->state.map->build();
     
     state.font_texture_id = Utility::load_texture("assets/texture/font1.png");
     
+    /**
+     Sprite atlas: everything the entities draw shares one texture page
+     */
+    delete state.atlas;
+    state.atlas = new TextureAtlas();
+    state.atlas->add("assets/texture/fireboy.png");
+    state.atlas->add("assets/texture/breakable.png");
+    state.atlas->add("assets/texture/heart.png");
+    state.atlas->add("assets/texture/monster.png");
+    state.atlas->add("assets/texture/jump.png");
+    state.atlas->add("assets/texture/fire.png");
+    state.atlas->build();
+    
     // Code from main.cpp's initialise()
     /**
      George's Stuff
@@ -57,7 +76,7 @@ void LevelA::initialise()
     state.player->speed = 2.5f;
     state.player->original_speed = 2.5f;
     state.player->set_acceleration(glm::vec3(0.0f, -7.81f, 0.0f));
-    state.player->texture_id = Utility::load_texture("assets/texture/fireboy.png");
+    state.player->texture_region = state.atlas->get_region("assets/texture/fireboy.png");
     
     // Walking
     state.player->walking[state.player->LEFT]  = new int[4] { 1, 5, 9,  13 };
@@ -78,97 +97,42 @@ void LevelA::initialise()
     state.player->jumping_power = 3.5f;
     
 //    breakable
-    GLuint breakable_texture_id = Utility::load_texture("assets/texture/breakable.png");
+    AtlasRegion breakable_region = state.atlas->get_region("assets/texture/breakable.png");
     state.breakable = new Entity[BREAK_COUNT];
     state.breakable[0].set_entity_type(BREAKABLE);
     state.breakable[0].set_position(glm::vec3(14.54f, -2.3f, 0.0f));
     state.breakable[0].set_size(glm::vec3(0.8f, 0.8f, 1.0f));
     state.breakable[0].set_movement(glm::vec3(0.0f));
-    state.breakable[0].texture_id = breakable_texture_id;
+    state.breakable[0].texture_region = breakable_region;
     
     state.breakable[1].set_entity_type(BREAKABLE);
     state.breakable[1].set_position(glm::vec3(16.54f, -2.3f, 0.0f));
     state.breakable[1].set_size(glm::vec3(0.8f, 0.8f, 1.0f));
     state.breakable[1].set_movement(glm::vec3(0.0f));
-    state.breakable[1].texture_id = breakable_texture_id;
+    state.breakable[1].texture_region = breakable_region;
     
     state.breakable[2].set_entity_type(BREAKABLE);
     state.breakable[2].set_position(glm::vec3(18.54f, -2.3f, 0.0f));
     state.breakable[2].set_size(glm::vec3(0.8f, 0.8f, 1.0f));
     state.breakable[2].set_movement(glm::vec3(0.0f));
-    state.breakable[2].texture_id = breakable_texture_id;
+    state.breakable[2].texture_region = breakable_region;
     
     state.breakable[3].set_entity_type(BREAKABLE);
     state.breakable[3].set_position(glm::vec3(18.54f, -1.97f, 0.0f));
     state.breakable[3].set_movement(glm::vec3(0.0f));
     state.breakable[3].set_size(glm::vec3(0.8f, 0.8f, 1.0f));
-    state.breakable[3].texture_id = Utility::load_texture("assets/texture/heart.png");
+    state.breakable[3].texture_region = state.atlas->get_region("assets/texture/heart.png");
     state.breakable[3].deactivate();
     
-    state.breakable[4].set_entity_type(BREAKABLE);
-    state.breakable[4].set_position(glm::vec3(47.0f, -4.0f, 0.0f));
-    state.breakable[4].set_movement(glm::vec3(0.0f));
-    state.breakable[4].texture_id = breakable_texture_id;
-    
-    state.breakable[5].set_entity_type(BREAKABLE);
-    state.breakable[5].set_position(glm::vec3(48.0f, -4.0f, 0.0f));
-    state.breakable[5].set_movement(glm::vec3(0.0f));
-    state.breakable[5].texture_id = breakable_texture_id;
-
-    state.breakable[6].set_entity_type(BREAKABLE);
-    state.breakable[6].set_position(glm::vec3(49.0f, -4.0f, 0.0f));
-    state.breakable[6].set_movement(glm::vec3(0.0f));
-    state.breakable[6].texture_id = breakable_texture_id;
-    
-    state.breakable[7].set_entity_type(BREAKABLE);
-    state.breakable[7].set_position(glm::vec3(50.0f, -4.0f, 0.0f));
-    state.breakable[7].set_movement(glm::vec3(0.0f));
-    state.breakable[7].texture_id = breakable_texture_id;
-    
-    state.breakable[8].set_entity_type(BREAKABLE);
-    state.breakable[8].set_position(glm::vec3(51.0f, -4.0f, 0.0f));
-    state.breakable[8].set_movement(glm::vec3(0.0f));
-    state.breakable[8].texture_id = breakable_texture_id;
-    
-    state.breakable[9].set_entity_type(BREAKABLE);
-    state.breakable[9].set_position(glm::vec3(52.0f, -4.0f, 0.0f));
-    state.breakable[9].set_movement(glm::vec3(0.0f));
-    state.breakable[9].texture_id = breakable_texture_id;
-    
-    state.breakable[10].set_entity_type(BREAKABLE);
-    state.breakable[10].set_position(glm::vec3(53.0f, -4.0f, 0.0f));
-    state.breakable[10].set_movement(glm::vec3(0.0f));
-    state.breakable[10].texture_id = breakable_texture_id;
-    
-    state.breakable[11].set_entity_type(BREAKABLE);
-    state.breakable[11].set_position(glm::vec3(54.0f, -4.0f, 0.0f));
-    state.breakable[11].set_movement(glm::vec3(0.0f));
-    state.breakable[11].texture_id = breakable_texture_id;
-    
-    state.breakable[12].set_entity_type(BREAKABLE);
-    state.breakable[12].set_position(glm::vec3(55.0f, -4.0f, 0.0f));
-    state.breakable[12].set_movement(glm::vec3(0.0f));
-    state.breakable[12].texture_id = breakable_texture_id;
-    
-    state.breakable[13].set_entity_type(BREAKABLE);
-    state.breakable[13].set_position(glm::vec3(56.0f, -4.0f, 0.0f));
-    state.breakable[13].set_movement(glm::vec3(0.0f));
-    state.breakable[13].texture_id = breakable_texture_id;
-    
-    state.breakable[14].set_entity_type(BREAKABLE);
-    state.breakable[14].set_position(glm::vec3(57.0f, -4.0f, 0.0f));
-    state.breakable[14].set_movement(glm::vec3(0.0f));
-    state.breakable[14].texture_id = breakable_texture_id;
-    
     /**
      Enemies' stuff */
-    GLuint enemy_texture_id = Utility::load_texture("assets/texture/monster.png");
+    AtlasRegion enemy_region = state.atlas->get_region("assets/texture/monster.png");
     
     state.enemies = new Entity[this->ENEMY_COUNT];
     state.enemies[0].set_entity_type(ENEMY);
     state.enemies[0].set_ai_type(WALKER);
     state.enemies[0].set_ai_state(WALKING);
-    state.enemies[0].texture_id = enemy_texture_id;
+    state.enemies[0].texture_region = enemy_region;
     state.enemies[0].set_position(glm::vec3(8.0f, -5.0f, 0.0f));
     state.enemies[0].set_movement(glm::vec3(0.0f));
     state.enemies[0].speed = 1.0f;
@@ -177,7 +141,7 @@ void LevelA::initialise()
     state.enemies[1].set_entity_type(ENEMY);
     state.enemies[1].set_ai_type(GUARD);
     state.enemies[1].set_ai_state(IDLE);
-    state.enemies[1].texture_id = enemy_texture_id;
+    state.enemies[1].texture_region = enemy_region;
     state.enemies[1].set_position(glm::vec3(11.0f, -4.0f, 0.0f));
     state.enemies[1].set_movement(glm::vec3(0.0f));
     state.enemies[1].speed = 1.0f;
@@ -186,7 +150,7 @@ void LevelA::initialise()
     state.enemies[2].set_entity_type(ENEMY);
     state.enemies[2].set_ai_type(GUARD);
     state.enemies[2].set_ai_state(IDLE);
-    state.enemies[2].texture_id = enemy_texture_id;
+    state.enemies[2].texture_region = enemy_region;
     state.enemies[2].set_position(glm::vec3(14.54f, -1.0f, 0.0f));
     state.enemies[2].set_movement(glm::vec3(0.0f));
     state.enemies[2].speed = 1.0f;
@@ -197,7 +161,7 @@ void LevelA::initialise()
     state.enemies[3].set_entity_type(ENEMY);
     state.enemies[3].set_ai_type(FLYER);
     state.enemies[3].set_ai_state(WALKING);
-    state.enemies[3].texture_id = enemy_texture_id;
+    state.enemies[3].texture_region = enemy_region;
     state.enemies[3].set_position(glm::vec3(26.0f, -1.0f, 0.0f));
     state.enemies[3].set_movement(glm::vec3(0.0f));
     state.enemies[3].speed = 1.0f;
@@ -206,7 +170,7 @@ void LevelA::initialise()
     state.enemies[4].set_entity_type(ENEMY);
     state.enemies[4].set_ai_type(FLYER);
     state.enemies[4].set_ai_state(WALKING);
-    state.enemies[4].texture_id = enemy_texture_id;
+    state.enemies[4].texture_region = enemy_region;
     state.enemies[4].set_position(glm::vec3(30.0f, -3.0f, 0.0f));
     state.enemies[4].set_movement(glm::vec3(0.0f));
     state.enemies[4].speed = 1.0f;
@@ -215,7 +179,7 @@ void LevelA::initialise()
     state.enemies[5].set_entity_type(ENEMY);
     state.enemies[5].set_ai_type(ATTACKER);
     state.enemies[5].set_ai_state(IDLE);
-    state.enemies[5].texture_id = enemy_texture_id;
+    state.enemies[5].texture_region = enemy_region;
     state.enemies[5].set_position(glm::vec3(44.0f, -5.0f, 0.0f));
     state.enemies[5].set_movement(glm::vec3(0.0f));
     state.enemies[5].speed = 1.0f;
@@ -224,7 +188,7 @@ void LevelA::initialise()
     state.enemies[6].set_entity_type(ENEMY);
     state.enemies[6].set_ai_type(GUARD);
     state.enemies[6].set_ai_state(IDLE);
-    state.enemies[6].texture_id = enemy_texture_id;
+    state.enemies[6].texture_region = enemy_region;
     state.enemies[6].set_position(glm::vec3(57.0f, -5.0f, 0.0f));
     state.enemies[6].set_movement(glm::vec3(0.0f));
     state.enemies[6].speed = 1.0f;
@@ -233,7 +197,7 @@ void LevelA::initialise()
     state.enemies[7].set_entity_type(ENEMY);
     state.enemies[7].set_ai_type(GUARD);
     state.enemies[7].set_ai_state(IDLE);
-    state.enemies[7].texture_id = enemy_texture_id;
+    state.enemies[7].texture_region = enemy_region;
     state.enemies[7].set_position(glm::vec3(49.0f, -5.0f, 0.0f));
     state.enemies[7].set_movement(glm::vec3(0.0f));
     state.enemies[7].speed = 1.0f;
@@ -242,7 +206,7 @@ void LevelA::initialise()
     state.enemies[8].set_entity_type(ENEMY);
     state.enemies[8].set_ai_type(GUARD);
     state.enemies[8].set_ai_state(IDLE);
-    state.enemies[8].texture_id = enemy_texture_id;
+    state.enemies[8].texture_region = enemy_region;
     state.enemies[8].set_position(glm::vec3(50.0f, -5.0f, 0.0f));
     state.enemies[8].set_movement(glm::vec3(0.0f));
     state.enemies[8].speed = 1.0f;
@@ -251,7 +215,7 @@ void LevelA::initialise()
     state.enemies[9].set_entity_type(ENEMY);
     state.enemies[9].set_ai_type(GUARD);
     state.enemies[9].set_ai_state(IDLE);
-    state.enemies[9].texture_id = enemy_texture_id;
+    state.enemies[9].texture_region = enemy_region;
     state.enemies[9].set_position(glm::vec3(51.0f, -5.0f, 0.0f));
     state.enemies[9].set_movement(glm::vec3(0.0f));
     state.enemies[9].speed = 1.0f;
@@ -260,7 +224,7 @@ void LevelA::initialise()
     state.enemies[10].set_entity_type(ENEMY);
     state.enemies[10].set_ai_type(GUARD);
     state.enemies[10].set_ai_state(IDLE);
-    state.enemies[10].texture_id = enemy_texture_id;
+    state.enemies[10].texture_region = enemy_region;
     state.enemies[10].set_position(glm::vec3(52.0f, -5.0f, 0.0f));
     state.enemies[10].set_movement(glm::vec3(0.0f));
     state.enemies[10].speed = 1.0f;
@@ -269,7 +233,7 @@ void LevelA::initialise()
     state.enemies[11].set_entity_type(ENEMY);
     state.enemies[11].set_ai_type(GUARD);
     state.enemies[11].set_ai_state(IDLE);
-    state.enemies[11].texture_id = enemy_texture_id;
+    state.enemies[11].texture_region = enemy_region;
     state.enemies[11].set_position(glm::vec3(53.0f, -5.0f, 0.0f));
     state.enemies[11].set_movement(glm::vec3(0.0f));
     state.enemies[11].speed = 1.0f;
@@ -278,7 +242,7 @@ void LevelA::initialise()
     state.enemies[12].set_entity_type(ENEMY);
     state.enemies[12].set_ai_type(GUARD);
     state.enemies[12].set_ai_state(IDLE);
-    state.enemies[12].texture_id = enemy_texture_id;
+    state.enemies[12].texture_region = enemy_region;
     state.enemies[12].set_position(glm::vec3(54.0f, -5.0f, 0.0f));
     state.enemies[12].set_movement(glm::vec3(0.0f));
     state.enemies[12].speed = 1.0f;
@@ -287,7 +251,7 @@ void LevelA::initialise()
     state.enemies[13].set_entity_type(ENEMY);
     state.enemies[13].set_ai_type(GUARD);
     state.enemies[13].set_ai_state(IDLE);
-    state.enemies[13].texture_id = enemy_texture_id;
+    state.enemies[13].texture_region = enemy_region;
     state.enemies[13].set_position(glm::vec3(55.0f, -5.0f, 0.0f));
     state.enemies[13].set_movement(glm::vec3(0.0f));
     state.enemies[13].speed = 1.0f;
@@ -296,7 +260,7 @@ void LevelA::initialise()
     state.enemies[14].set_entity_type(ENEMY);
     state.enemies[14].set_ai_type(GUARD);
     state.enemies[14].set_ai_state(IDLE);
-    state.enemies[14].texture_id = enemy_texture_id;
+    state.enemies[14].texture_region = enemy_region;
     state.enemies[14].set_position(glm::vec3(56.0f, -5.0f, 0.0f));
     state.enemies[14].set_movement(glm::vec3(0.0f));
     state.enemies[14].speed = 1.0f;
@@ -308,27 +272,30 @@ void LevelA::initialise()
     state.jumper[0].set_position(glm::vec3(31.5f, -6.5f, 0.0f));
     state.jumper[0].set_movement(glm::vec3(0.0f));
     state.jumper[0].set_size(glm::vec3(0.8f, 0.8f, 1.0f));
-    state.jumper[0].texture_id = Utility::load_texture("assets/texture/jump.png");
+    state.jumper[0].texture_region = state.atlas->get_region("assets/texture/jump.png");
     
     state.jumper[1].set_entity_type(JUMPER);
     state.jumper[1].set_position(glm::vec3(22.5f, -3.0f, 0.0f));
     state.jumper[1].set_movement(glm::vec3(0.0f));
     state.jumper[1].set_size(glm::vec3(0.8f, 0.8f, 1.0f));
-    state.jumper[1].texture_id = Utility::load_texture("assets/texture/jump.png");
+    state.jumper[1].texture_region = state.atlas->get_region("assets/texture/jump.png");
     
     state.jumper[2].set_entity_type(JUMPER);
     state.jumper[2].set_position(glm::vec3(45.5f, -4.0f, 0.0f));
     state.jumper[2].set_movement(glm::vec3(0.0f));
     state.jumper[2].set_size(glm::vec3(0.8f, 0.8f, 1.0f));
-    state.jumper[2].texture_id = Utility::load_texture("assets/texture/jump.png");
+    state.jumper[2].texture_region = state.atlas->get_region("assets/texture/jump.png");
     
     state.weapon = new Entity();
     state.weapon->set_entity_type(WEAPON);
-    state.weapon->texture_id = Utility::load_texture("assets/texture/fire.png");
+    state.weapon->texture_region = state.atlas->get_region("assets/texture/fire.png");
     state.weapon->set_position(glm::vec3(43.0f, -6.0f, 0.0f));
     state.weapon->set_movement(glm::vec3(-1.0f, 0.0f, 0.0f));
     state.weapon->speed = 10.0f;
     state.weapon->set_acceleration(glm::vec3(0.0f, 0.0f, 0.0f));
+    state.weapon->light_radius = 2.5f;
+    state.weapon->light_intensity = 0.8f;
+    state.weapon->light_color = glm::vec3(1.0f, 0.55f, 0.2f);
     state.weapon->deactivate();
     
 //    state.background = new Entity();
@@ -416,19 +383,31 @@ void LevelA::render(ShaderProgram *program)
 //    this->state.background->render(program);
     if(state.mission_failed)
     {
-        Utility::draw_text(program, this->state.font_texture_id, "MISSION FAILED!", 0.5f, 0.25f, glm::vec3(state.player->get_position().x-2.0f, -3.0f, 0.0f));
+        this->render_queue.submit_text(program, this->state.font_texture_id, FAILED_TEXT, 0.5f, 0.25f, glm::vec3(state.player->get_position().x-2.0f, -3.0f, 0.0f), glm::vec3(state.player->get_previous_position().x-2.0f, -3.0f, 0.0f));
     }
     
     if(state.player->get_position().x > LEVEL1_LEFT_EDGE){
-        Utility::draw_text(program, this->state.font_texture_id, "lives: " + std::to_string(num_of_lives), 0.5f, 0.25f, glm::vec3(state.player->get_position().x - 4.0f, -1.0f, 0.0f));
+        this->render_queue.submit_text(program, this->state.font_texture_id, this->get_lives_label(), 0.5f, 0.25f, glm::vec3(state.player->get_position().x - 4.0f, -1.0f, 0.0f), glm::vec3(state.player->get_previous_position().x - 4.0f, -1.0f, 0.0f));
     } else {
-        Utility::draw_text(program, this->state.font_texture_id, "lives: " + std::to_string(num_of_lives), 0.5f, 0.25f, glm::vec3(1.0f, -1.0f, 0.0f));
+        this->render_queue.submit_text(program, this->state.font_texture_id, this->get_lives_label(), 0.5f, 0.25f, glm::vec3(1.0f, -1.0f, 0.0f));
+    }
+    
+    // Blocks and jumpers never move; only which of them are still there changes the static layer
+    Uint64 static_key = 0;
+    for (int i = 0; i < BREAK_COUNT; i++)  static_key |= (Uint64) state.breakable[i].get_is_active() << i;
+    for (int i = 0; i < JUMPER_COUNT; i++) static_key |= (Uint64) state.jumper[i].get_is_active() << (BREAK_COUNT + i);
+    
+    if (this->static_layer.begin(this->state.map, static_key))
+    {
+        RenderQueue &static_queue = this->static_layer.get_queue();
+        static_queue.submit_map(program, this->state.map);
+        for (int i = 0; i < BREAK_COUNT; i++) state.breakable[i].render(&static_queue, program);
+        for (int i = 0; i < JUMPER_COUNT; i++) state.jumper[i].render(&static_queue, program);
+        this->static_layer.end();
     }
+    this->render_queue.submit_static_layer(program, &this->static_layer, &this->visibility);
     
-    this->state.weapon->render(program);
-    this->state.map->render(program);
-    this->state.player->render(program);
-    for (int i = 0; i < ENEMY_COUNT; i++) state.enemies[i].render(program);
-    for (int i = 0; i < BREAK_COUNT; i++) state.breakable[i].render(program);
-    for (int i = 0; i < JUMPER_COUNT; i++) state.jumper[i].render(program);
+    this->state.weapon->render(&this->render_queue, program, &this->visibility);
+    this->state.player->render(&this->render_queue, program, &this->visibility);
+    for (int i = 0; i < ENEMY_COUNT; i++) state.enemies[i].render(&this->render_queue, program, &this->visibility);
 }
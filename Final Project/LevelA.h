@@ -4,7 +4,7 @@ class LevelA : public Scene {
     
 public:
     int ENEMY_COUNT = 15;
-    int BREAK_COUNT = 15;
+    int BREAK_COUNT = 4;
     int JUMPER_COUNT = 3;
     
     ~LevelA();
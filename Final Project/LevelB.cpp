@@ -11,6 +11,8 @@ const float BG_RED     = 0.0f,
             BG_GREEN   = 0.0f,
             BG_OPACITY = 1.0f;
 
+const std::string FAILED_TEXT = "MISSION FAILED!";
+
 unsigned int LEVELB_DATA[] =
 {
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -28,6 +30,7 @@ LevelB::~LevelB()
     delete [] this->state.enemies;
     delete    this->state.player;
     delete    this->state.map;
+    delete    this->state.atlas;
     delete    this->state.weapon;
     delete    this->state.item;
     Mix_FreeChunk(this->state.jump_sfx);
@@ -41,11 +44,23 @@ void LevelB::initialise()
     state.next_scene_id = -1;
     state.mission_failed = false;
     
-    GLuint map_texture_id = Utility::load_texture("assets/texture/greenzone_tileset.png");
-    this->state.map = new Map(LEVEL_WIDTH, LEVEL_HEIGHT, LEVELB_DATA, map_texture_id, 1.0f, 4, 1);
+    this->state.map = new Map(LEVEL_WIDTH, LEVEL_HEIGHT, 1.0f);
+    this->state.map->add_layer(LEVELB_DATA, "assets/texture/greenzone_tileset.png", 4, 1);
+    this->state.map->build();
     
     state.font_texture_id = Utility::load_texture("assets/texture/font1.png");
     
+    /**
+     Sprite atlas: everything the entities draw shares one texture page
+     */
+    delete state.atlas;
+    state.atlas = new TextureAtlas();
+    state.atlas->add("assets/texture/fireboy.png");
+    state.atlas->add("assets/texture/monster.png");
+    state.atlas->add("assets/texture/item.png");
+    state.atlas->add("assets/texture/fire.png");
+    state.atlas->build();
+    
     // Existing
     state.player = new Entity();
     state.player->set_entity_type(PLAYER);
@@ -54,7 +69,7 @@ void LevelB::initialise()
     state.player->speed = 2.5f;
     state.player->original_speed = 2.5f;
     state.player->set_acceleration(glm::vec3(0.0f, -7.81f, 0.0f));
-    state.player->texture_id = Utility::load_texture("assets/texture/fireboy.png");
+    state.player->texture_region = state.atlas->get_region("assets/texture/fireboy.png");
     
     // Walking
     state.player->walking[state.player->LEFT]  = new int[4] { 1, 5, 9,  13 };
@@ -77,13 +92,13 @@ void LevelB::initialise()
     
     /**
      Enemies' stuff */
-    GLuint enemy_texture_id = Utility::load_texture("assets/texture/monster.png");
+    AtlasRegion enemy_region = state.atlas->get_region("assets/texture/monster.png");
     
     state.enemies = new Entity[this->ENEMY_COUNT];
     state.enemies[0].set_entity_type(ENEMY);
     state.enemies[0].set_ai_type(WALKER);
     state.enemies[0].set_ai_state(WALKING);
-    state.enemies[0].texture_id = enemy_texture_id;
+    state.enemies[0].texture_region = enemy_region;
     state.enemies[0].set_position(glm::vec3(6.0f, -4.0f, 0.0f));
     state.enemies[0].set_movement(glm::vec3(0.0f));
     state.enemies[0].speed = 1.0f;
@@ -92,7 +107,7 @@ void LevelB::initialise()
     state.enemies[1].set_entity_type(ENEMY);
     state.enemies[1].set_ai_type(WALKER);
     state.enemies[1].set_ai_state(WALKING);
-    state.enemies[1].texture_id = enemy_texture_id;
+    state.enemies[1].texture_region = enemy_region;
     state.enemies[1].set_position(glm::vec3(4.0f, -4.0f, 0.0f));
     state.enemies[1].set_movement(glm::vec3(0.0f));
     state.enemies[1].speed = 3.0f;
@@ -101,7 +116,7 @@ void LevelB::initialise()
     state.enemies[2].set_entity_type(ENEMY);
     state.enemies[2].set_ai_type(WALKER);
     state.enemies[2].set_ai_state(WALKING);
-    state.enemies[2].texture_id = enemy_texture_id;
+    state.enemies[2].texture_region = enemy_region;
     state.enemies[2].set_position(glm::vec3(5.0f, -1.0f, 0.0f));
     state.enemies[2].set_movement(glm::vec3(0.0f));
     state.enemies[2].speed = 2.0f;
@@ -110,7 +125,7 @@ void LevelB::initialise()
     state.enemies[3].set_entity_type(ENEMY);
     state.enemies[3].set_ai_type(WALKER);
     state.enemies[3].set_ai_state(WALKING);
-    state.enemies[3].texture_id = enemy_texture_id;
+    state.enemies[3].texture_region = enemy_region;
     state.enemies[3].set_position(glm::vec3(14.0f, -1.0f, 0.0f));
     state.enemies[3].set_movement(glm::vec3(-1.0f));
     state.enemies[3].speed = 1.0f;
@@ -119,7 +134,7 @@ void LevelB::initialise()
     state.enemies[4].set_entity_type(ENEMY);
     state.enemies[4].set_ai_type(WALKER);
     state.enemies[4].set_ai_state(WALKING);
-    state.enemies[4].texture_id = enemy_texture_id;
+    state.enemies[4].texture_region = enemy_region;
     state.enemies[4].set_position(glm::vec3(16.0f, -3.0f, 0.0f));
     state.enemies[4].set_movement(glm::vec3(0.0f));
     state.enemies[4].speed = 1.5f;
@@ -128,7 +143,7 @@ void LevelB::initialise()
     state.enemies[5].set_entity_type(ENEMY);
     state.enemies[5].set_ai_type(WALKER);
     state.enemies[5].set_ai_state(WALKING);
-    state.enemies[5].texture_id = enemy_texture_id;
+    state.enemies[5].texture_region = enemy_region;
     state.enemies[5].set_position(glm::vec3(12.0f, -1.0f, 0.0f));
     state.enemies[5].set_movement(glm::vec3(0.0f));
     state.enemies[5].speed = 1.0f;
@@ -137,7 +152,7 @@ void LevelB::initialise()
     state.enemies[6].set_entity_type(ENEMY);
     state.enemies[6].set_ai_type(GUARD);
     state.enemies[6].set_ai_state(IDLE);
-    state.enemies[6].texture_id = enemy_texture_id;
+    state.enemies[6].texture_region = enemy_region;
     state.enemies[6].set_position(glm::vec3(18.0f, -1.0f, 0.0f));
     state.enemies[6].set_movement(glm::vec3(0.0f));
     state.enemies[6].speed = 2.0f;
@@ -146,7 +161,7 @@ void LevelB::initialise()
     state.enemies[7].set_entity_type(ENEMY);
     state.enemies[7].set_ai_type(GUARD);
     state.enemies[7].set_ai_state(IDLE);
-    state.enemies[7].texture_id = enemy_texture_id;
+    state.enemies[7].texture_region = enemy_region;
     state.enemies[7].set_position(glm::vec3(20.0f, -1.0f, 0.0f));
     state.enemies[7].set_movement(glm::vec3(0.0f));
     state.enemies[7].speed = 3.0f;
@@ -155,7 +170,7 @@ void LevelB::initialise()
     state.enemies[8].set_entity_type(ENEMY);
     state.enemies[8].set_ai_type(WALKER);
     state.enemies[8].set_ai_state(IDLE);
-    state.enemies[8].texture_id = enemy_texture_id;
+    state.enemies[8].texture_region = enemy_region;
     state.enemies[8].set_position(glm::vec3(21.0f, -1.0f, 0.0f));
     state.enemies[8].set_movement(glm::vec3(0.0f));
     state.enemies[8].speed = 1.5f;
@@ -164,7 +179,7 @@ void LevelB::initialise()
     state.enemies[9].set_entity_type(ENEMY);
     state.enemies[9].set_ai_type(WALKER);
     state.enemies[9].set_ai_state(IDLE);
-    state.enemies[9].texture_id = enemy_texture_id;
+    state.enemies[9].texture_region = enemy_region;
     state.enemies[9].set_position(glm::vec3(22.0f, -1.0f, 0.0f));
     state.enemies[9].set_movement(glm::vec3(0.0f));
     state.enemies[9].speed = 1.0f;
@@ -173,7 +188,7 @@ void LevelB::initialise()
     state.enemies[10].set_entity_type(ENEMY);
     state.enemies[10].set_ai_type(WALKER);
     state.enemies[10].set_ai_state(IDLE);
-    state.enemies[10].texture_id = enemy_texture_id;
+    state.enemies[10].texture_region = enemy_region;
     state.enemies[10].set_position(glm::vec3(23.0f, -5.0f, 0.0f));
     state.enemies[10].set_movement(glm::vec3(0.0f));
     state.enemies[10].speed = 1.0f;
@@ -182,7 +197,7 @@ void LevelB::initialise()
     state.enemies[11].set_entity_type(ENEMY);
     state.enemies[11].set_ai_type(WALKER);
     state.enemies[11].set_ai_state(IDLE);
-    state.enemies[11].texture_id = enemy_texture_id;
+    state.enemies[11].texture_region = enemy_region;
     state.enemies[11].set_position(glm::vec3(24.0f, -5.0f, 0.0f));
     state.enemies[11].set_movement(glm::vec3(0.0f));
     state.enemies[11].speed = 1.0f;
@@ -191,7 +206,7 @@ void LevelB::initialise()
     state.enemies[12].set_entity_type(ENEMY);
     state.enemies[12].set_ai_type(WALKER);
     state.enemies[12].set_ai_state(IDLE);
-    state.enemies[12].texture_id = enemy_texture_id;
+    state.enemies[12].texture_region = enemy_region;
     state.enemies[12].set_position(glm::vec3(25.0f, -5.0f, 0.0f));
     state.enemies[12].set_movement(glm::vec3(0.0f));
     state.enemies[12].speed = 2.0f;
@@ -200,7 +215,7 @@ void LevelB::initialise()
     state.enemies[13].set_entity_type(ENEMY);
     state.enemies[13].set_ai_type(WALKER);
     state.enemies[13].set_ai_state(IDLE);
-    state.enemies[13].texture_id = enemy_texture_id;
+    state.enemies[13].texture_region = enemy_region;
     state.enemies[13].set_position(glm::vec3(26.0f, -5.0f, 0.0f));
     state.enemies[13].set_movement(glm::vec3(0.0f));
     state.enemies[13].speed = 2.0f;
@@ -209,7 +224,7 @@ void LevelB::initialise()
     state.enemies[14].set_entity_type(ENEMY);
     state.enemies[14].set_ai_type(WALKER);
     state.enemies[14].set_ai_state(IDLE);
-    state.enemies[14].texture_id = enemy_texture_id;
+    state.enemies[14].texture_region = enemy_region;
     state.enemies[14].set_position(glm::vec3(27.0f, -5.0f, 0.0f));
     state.enemies[14].set_movement(glm::vec3(0.0f));
     state.enemies[14].speed = 2.0f;
@@ -218,7 +233,7 @@ void LevelB::initialise()
     state.enemies[15].set_entity_type(ENEMY);
     state.enemies[15].set_ai_type(WALKER);
     state.enemies[15].set_ai_state(IDLE);
-    state.enemies[15].texture_id = enemy_texture_id;
+    state.enemies[15].texture_region = enemy_region;
     state.enemies[15].set_position(glm::vec3(28.0f, -5.0f, 0.0f));
     state.enemies[15].set_movement(glm::vec3(0.0f));
     state.enemies[15].speed = 2.0f;
@@ -227,7 +242,7 @@ void LevelB::initialise()
     state.enemies[16].set_entity_type(ENEMY);
     state.enemies[16].set_ai_type(WALKER);
     state.enemies[16].set_ai_state(IDLE);
-    state.enemies[16].texture_id = enemy_texture_id;
+    state.enemies[16].texture_region = enemy_region;
     state.enemies[16].set_position(glm::vec3(29.0f, -5.0f, 0.0f));
     state.enemies[16].set_movement(glm::vec3(0.0f));
     state.enemies[16].speed = 2.0f;
@@ -236,7 +251,7 @@ void LevelB::initialise()
     state.enemies[17].set_entity_type(ENEMY);
     state.enemies[17].set_ai_type(WALKER);
     state.enemies[17].set_ai_state(IDLE);
-    state.enemies[17].texture_id = enemy_texture_id;
+    state.enemies[17].texture_region = enemy_region;
     state.enemies[17].set_position(glm::vec3(30.0f, -5.0f, 0.0f));
     state.enemies[17].set_movement(glm::vec3(0.0f));
     state.enemies[17].speed = 2.0f;
@@ -245,7 +260,7 @@ void LevelB::initialise()
     state.enemies[18].set_entity_type(ENEMY);
     state.enemies[18].set_ai_type(WALKER);
     state.enemies[18].set_ai_state(IDLE);
-    state.enemies[18].texture_id = enemy_texture_id;
+    state.enemies[18].texture_region = enemy_region;
     state.enemies[18].set_position(glm::vec3(31.0f, -5.0f, 0.0f));
     state.enemies[18].set_movement(glm::vec3(0.0f));
     state.enemies[18].speed = 2.0f;
@@ -254,7 +269,7 @@ void LevelB::initialise()
     state.enemies[19].set_entity_type(ENEMY);
     state.enemies[19].set_ai_type(WALKER);
     state.enemies[19].set_ai_state(IDLE);
-    state.enemies[19].texture_id = enemy_texture_id;
+    state.enemies[19].texture_region = enemy_region;
     state.enemies[19].set_position(glm::vec3(32.0f, -5.0f, 0.0f));
     state.enemies[19].set_movement(glm::vec3(0.0f));
     state.enemies[19].speed = 2.0f;
@@ -263,7 +278,7 @@ void LevelB::initialise()
     state.enemies[20].set_entity_type(ENEMY);
     state.enemies[20].set_ai_type(WALKER);
     state.enemies[20].set_ai_state(IDLE);
-    state.enemies[20].texture_id = enemy_texture_id;
+    state.enemies[20].texture_region = enemy_region;
     state.enemies[20].set_position(glm::vec3(33.0f, -5.0f, 0.0f));
     state.enemies[20].set_movement(glm::vec3(0.0f));
     state.enemies[20].speed = 2.0f;
@@ -272,28 +287,34 @@ void LevelB::initialise()
     state.enemies[21].set_entity_type(ENEMY);
     state.enemies[21].set_ai_type(WALKER);
     state.enemies[21].set_ai_state(IDLE);
-    state.enemies[21].texture_id = enemy_texture_id;
+    state.enemies[21].texture_region = enemy_region;
     state.enemies[21].set_position(glm::vec3(34.0f, -5.0f, 0.0f));
     state.enemies[21].set_movement(glm::vec3(0.0f));
     state.enemies[21].speed = 2.0f;
     state.enemies[21].set_acceleration(glm::vec3(0.0f, -7.3f, 0.0f));
     
     //jumper stuff
-    GLuint item_texture_id = Utility::load_texture("assets/texture/item.png");
+    AtlasRegion item_region = state.atlas->get_region("assets/texture/item.png");
     state.item = new Entity();
     state.item->set_entity_type(ITEM);
     state.item->set_position(glm::vec3(18.0f, -5.0f, 0.0f));
     state.item->set_size(glm::vec3(0.8f, 0.8f, 1.0f));
     state.item->set_movement(glm::vec3(0.0f));
-    state.item->texture_id = item_texture_id;
+    state.item->texture_region = item_region;
+    state.item->light_radius = 1.5f;
+    state.item->light_intensity = 0.5f;
+    state.item->light_color = glm::vec3(1.0f, 0.9f, 0.5f);
     
     state.weapon = new Entity();
     state.weapon->set_entity_type(WEAPON);
-    state.weapon->texture_id = Utility::load_texture("assets/texture/fire.png");
+    state.weapon->texture_region = state.atlas->get_region("assets/texture/fire.png");
     state.weapon->set_position(glm::vec3(6.0f, -3.0f, 0.0f));
     state.weapon->set_movement(glm::vec3(-1.0f, 0.0f, 0.0f));
     state.weapon->speed = 10.0f;
     state.weapon->set_acceleration(glm::vec3(0.0f, 0.0f, 0.0f));
+    state.weapon->light_radius = 2.5f;
+    state.weapon->light_intensity = 0.8f;
+    state.weapon->light_color = glm::vec3(1.0f, 0.55f, 0.2f);
     state.weapon->deactivate();
     /**
      BGM and SFX
@@ -373,17 +394,23 @@ void LevelB::update(float delta_time) {
 void LevelB::render(ShaderProgram *program)
 {
     if(state.player->get_position().x > LEVEL1_LEFT_EDGE){
-        Utility::draw_text(program, this->state.font_texture_id, "lives: " + std::to_string(num_of_lives), 0.5f, 0.25f, glm::vec3(state.player->get_position().x - 4.0f, -1.0f, 0.0f));
+        this->render_queue.submit_text(program, this->state.font_texture_id, this->get_lives_label(), 0.5f, 0.25f, glm::vec3(state.player->get_position().x - 4.0f, -1.0f, 0.0f), glm::vec3(state.player->get_previous_position().x - 4.0f, -1.0f, 0.0f));
     } else {
-        Utility::draw_text(program, this->state.font_texture_id, "lives: " + std::to_string(num_of_lives), 0.5f, 0.25f, glm::vec3(1.0f, -1.0f, 0.0f));
+        this->render_queue.submit_text(program, this->state.font_texture_id, this->get_lives_label(), 0.5f, 0.25f, glm::vec3(1.0f, -1.0f, 0.0f));
     }
     if(state.mission_failed)
     {
-        Utility::draw_text(program, this->state.font_texture_id, "MISSION FAILED!", 0.5f, 0.25f, glm::vec3(state.player->get_position().x-2.0f, -2.0f, 0.0f));
+        this->render_queue.submit_text(program, this->state.font_texture_id, FAILED_TEXT, 0.5f, 0.25f, glm::vec3(state.player->get_position().x-2.0f, -2.0f, 0.0f), glm::vec3(state.player->get_previous_position().x-2.0f, -2.0f, 0.0f));
     }
-    this->state.map->render(program);
-    this->state.weapon->render(program);
-    this->state.player->render(program);
-    for (int i = 0; i < ENEMY_COUNT; i++) state.enemies[i].render(program);
-    this->state.item->render(program);
+    if (this->static_layer.begin(this->state.map))
+    {
+        this->static_layer.get_queue().submit_map(program, this->state.map);
+        this->static_layer.end();
+    }
+    this->render_queue.submit_static_layer(program, &this->static_layer, &this->visibility);
+    
+    this->state.weapon->render(&this->render_queue, program, &this->visibility);
+    this->state.player->render(&this->render_queue, program, &this->visibility);
+    for (int i = 0; i < ENEMY_COUNT; i++) state.enemies[i].render(&this->render_queue, program, &this->visibility);
+    this->state.item->render(&this->render_queue, program, &this->visibility);
 }
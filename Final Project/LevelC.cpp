@@ -9,6 +9,9 @@ const float BG_RED     = 0.1922f,
             BG_GREEN   = 0.9059f,
             BG_OPACITY = 1.0f;
 
+const std::string FAILED_TEXT  = "MISSION FAILED!",
+                  SUCCESS_TEXT = "MISSION SUCCESSFUL!";
+
 unsigned int LEVELC_DATA[] =
 {
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -38,8 +41,9 @@ void LevelC::initialise()
     state.next_scene_id = -1;
     state.mission_failed = false;
     
-    GLuint map_texture_id = Utility::load_texture("assets/texture/tileset.png");
-    this->state.map = new Map(LEVEL_WIDTH, LEVEL_HEIGHT, LEVELC_DATA, map_texture_id, 1.0f, 4, 1);
+    this->state.map = new Map(LEVEL_WIDTH, LEVEL_HEIGHT, 1.0f);
+    this->state.map->add_layer(LEVELC_DATA, "assets/texture/tileset.png", 4, 1);
+    this->state.map->build();
     
     state.font_texture_id = Utility::load_texture("assets/texture/font1.png");
     
@@ -50,7 +54,7 @@ void LevelC::initialise()
     state.player->set_movement(glm::vec3(0.0f));
     state.player->speed = 2.5f;
     state.player->set_acceleration(glm::vec3(0.0f, -7.81f, 0.0f));
-    state.player->texture_id = Utility::load_texture("assets/texture/fireboy.png");
+    state.player->texture_region = Utility::load_texture("assets/texture/fireboy.png");
     
     // Walking
     state.player->walking[state.player->LEFT]  = new int[4] { 1, 5, 9,  13 };
@@ -96,12 +100,17 @@ void LevelC::render(ShaderProgram *program)
 {
     if(state.mission_failed)
     {
-        Utility::draw_text(program, this->state.font_texture_id, "MISSION FAILED!", 0.5f, 0.25f, glm::vec3(this->state.player->get_position().x - 2.0f, -3.0f, 1.0f));
+        this->render_queue.submit_text(program, this->state.font_texture_id, FAILED_TEXT, 0.5f, 0.25f, glm::vec3(this->state.player->get_position().x - 2.0f, -3.0f, 1.0f), glm::vec3(this->state.player->get_previous_position().x - 2.0f, -3.0f, 1.0f));
     }
     if(state.mission_success)
     {
-        Utility::draw_text(program, this->state.font_texture_id, "MISSION SUCCESSFUL!", 0.5f, 0.25f, glm::vec3(state.player->get_position().x - 2.0f, -3.0f, 0.0f));
+        this->render_queue.submit_text(program, this->state.font_texture_id, SUCCESS_TEXT, 0.5f, 0.25f, glm::vec3(state.player->get_position().x - 2.0f, -3.0f, 0.0f), glm::vec3(state.player->get_previous_position().x - 2.0f, -3.0f, 0.0f));
+    }
+    if (this->static_layer.begin(this->state.map))
+    {
+        this->static_layer.get_queue().submit_map(program, this->state.map);
+        this->static_layer.end();
     }
-    this->state.map->render(program);
-    this->state.player->render(program);
+    this->render_queue.submit_static_layer(program, &this->static_layer, &this->visibility);
+    this->state.player->render(&this->render_queue, program, &this->visibility);
 }
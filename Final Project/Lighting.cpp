@@ -0,0 +1,172 @@
+#define LEVEL_OF_DETAIL 0    // base image level; Level n is the nth mipmap reduction image
+#define TEXTURE_BORDER 0     // this value MUST be zero
+
+#include "Lighting.h"
+#include "GLState.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(GL_RGBA32F)
+#define LIGHTING_FLOAT_FORMAT GL_RGBA32F
+#elif defined(GL_RGBA32F_ARB)
+#define LIGHTING_FLOAT_FORMAT GL_RGBA32F_ARB
+#endif
+
+Lighting::Lighting(ShaderProgram *program)
+{
+    this->program = program;
+    
+    this->enabled_uniform     = glGetUniformLocation(program->programID, "lightingEnabled");
+    this->ambient_uniform     = glGetUniformLocation(program->programID, "ambient");
+    this->grid_origin_uniform = glGetUniformLocation(program->programID, "lightGridOrigin");
+    this->grid_scale_uniform  = glGetUniformLocation(program->programID, "lightGridScale");
+    
+#ifdef LIGHTING_FLOAT_FORMAT
+    // Float textures are core from 3.0 and an extension before that
+    const char *version = (const char *) glGetString(GL_VERSION);
+    const char *extensions = (const char *) glGetString(GL_EXTENSIONS);
+    this->supported = (version != NULL && version[0] >= '3') ||
+                      (extensions != NULL && strstr(extensions, "GL_ARB_texture_float") != NULL);
+#endif
+    
+    GLState::use_program(program->programID);
+    glUniform1f(this->enabled_uniform, 0.0f);
+    if (!this->supported) return;
+    
+    // STEP 1: Row 0 is (x, y, radius, intensity) and row 1 the colour, one column per light
+    this->light_texels.assign(MAX_LIGHTS * 2 * 4, 0.0f);
+    this->light_texture_id = create_float_texture(MAX_LIGHTS, 2);
+    
+    // STEP 2: Per tile, a count texel and then the light indices, four to a texel
+    this->tile_texels.assign(TILE_COLUMNS * SLOTS_PER_TILE * TILE_ROWS * 4, 0.0f);
+    this->tile_counts.assign(TILE_COLUMNS * TILE_ROWS, 0);
+    this->tile_texture_id = create_float_texture(TILE_COLUMNS * SLOTS_PER_TILE, TILE_ROWS);
+    
+    glUniform1i(glGetUniformLocation(program->programID, "lightData"), 1);
+    glUniform1i(glGetUniformLocation(program->programID, "lightTiles"), 2);
+}
+
+Lighting::~Lighting()
+{
+    GLState::delete_texture(this->light_texture_id);
+    GLState::delete_texture(this->tile_texture_id);
+}
+
+GLuint Lighting::create_float_texture(int width, int height)
+{
+    GLuint texture_id = 0;
+    
+#ifdef LIGHTING_FLOAT_FORMAT
+    // Texture units other than 0 are ours alone, so GLState doesn't track them
+    glGenTextures(1, &texture_id);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    glTexImage2D(GL_TEXTURE_2D, LEVEL_OF_DETAIL, LIGHTING_FLOAT_FORMAT, width, height, TEXTURE_BORDER, GL_RGBA, GL_FLOAT, NULL);
+    
+    // Data, not images: exact texels only
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    
+    glActiveTexture(GL_TEXTURE0);
+#endif
+    
+    return texture_id;
+}
+
+void Lighting::set_view(const Visibility &view)
+{
+    this->view_left = view.left;
+    this->view_bottom = view.bottom;
+    this->tile_width  = (view.right - view.left) / TILE_COLUMNS;
+    this->tile_height = (view.top - view.bottom) / TILE_ROWS;
+}
+
+void Lighting::bin(const std::vector<PointLight> &lights)
+{
+    std::fill(this->tile_counts.begin(), this->tile_counts.end(), 0);
+    
+    int light_count = std::min((int) lights.size(), MAX_LIGHTS);
+    int row_width = TILE_COLUMNS * SLOTS_PER_TILE;
+    
+    for (int i = 0; i < light_count; i++)
+    {
+        const PointLight &light = lights[i];
+        
+        float *data = &this->light_texels[i * 4];
+        float *color = &this->light_texels[(MAX_LIGHTS + i) * 4];
+        data[0] = light.position.x;
+        data[1] = light.position.y;
+        data[2] = light.radius;
+        data[3] = light.intensity;
+        color[0] = light.color.r;
+        color[1] = light.color.g;
+        color[2] = light.color.b;
+        
+        // Every tile the light's bounding square overlaps
+        int first_column = (int) floorf((light.position.x - light.radius - this->view_left) / this->tile_width);
+        int last_column  = (int) floorf((light.position.x + light.radius - this->view_left) / this->tile_width);
+        int first_row    = (int) floorf((light.position.y - light.radius - this->view_bottom) / this->tile_height);
+        int last_row     = (int) floorf((light.position.y + light.radius - this->view_bottom) / this->tile_height);
+        
+        first_column = std::max(first_column, 0);
+        last_column  = std::min(last_column, TILE_COLUMNS - 1);
+        first_row    = std::max(first_row, 0);
+        last_row     = std::min(last_row, TILE_ROWS - 1);
+        
+        for (int row = first_row; row <= last_row; row++)
+        {
+            for (int column = first_column; column <= last_column; column++)
+            {
+                int &count = this->tile_counts[row * TILE_COLUMNS + column];
+                if (count == MAX_LIGHTS_PER_TILE) continue;
+                
+                int texel = row * row_width + column * SLOTS_PER_TILE + 1 + count / 4;
+                this->tile_texels[texel * 4 + count % 4] = (float) i;
+                count++;
+            }
+        }
+    }
+    
+    for (int row = 0; row < TILE_ROWS; row++)
+    {
+        for (int column = 0; column < TILE_COLUMNS; column++)
+        {
+            this->tile_texels[(row * row_width + column * SLOTS_PER_TILE) * 4] = (float) this->tile_counts[row * TILE_COLUMNS + column];
+        }
+    }
+}
+
+void Lighting::begin(const std::vector<PointLight> &lights, glm::vec3 ambient)
+{
+    GLState::use_program(this->program->programID);
+    if (!this->supported) return;
+    
+    // STEP 1: Bin on the CPU...
+    this->bin(lights);
+    
+    // STEP 2: ...and upload both tables in one go each
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, this->light_texture_id);
+    glTexSubImage2D(GL_TEXTURE_2D, LEVEL_OF_DETAIL, 0, 0, MAX_LIGHTS, 2, GL_RGBA, GL_FLOAT, this->light_texels.data());
+    
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, this->tile_texture_id);
+    glTexSubImage2D(GL_TEXTURE_2D, LEVEL_OF_DETAIL, 0, 0, TILE_COLUMNS * SLOTS_PER_TILE, TILE_ROWS, GL_RGBA, GL_FLOAT, this->tile_texels.data());
+    
+    glActiveTexture(GL_TEXTURE0);
+    
+    // STEP 3: Where the grid sits in the world
+    glUniform1f(this->enabled_uniform, 1.0f);
+    glUniform3f(this->ambient_uniform, ambient.r, ambient.g, ambient.b);
+    glUniform2f(this->grid_origin_uniform, this->view_left, this->view_bottom);
+    glUniform2f(this->grid_scale_uniform, 1.0f / this->tile_width, 1.0f / this->tile_height);
+}
+
+void Lighting::end()
+{
+    GLState::use_program(this->program->programID);
+    glUniform1f(this->enabled_uniform, 0.0f);
+}
@@ -0,0 +1,75 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <vector>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "ShaderProgram.h"
+#include "Visibility.h"
+
+/**
+ A light in world space. Its contribution falls off to nothing at radius.
+ */
+struct PointLight
+{
+    glm::vec2 position;
+    float radius;
+    glm::vec3 color;
+    float intensity;
+};
+
+/**
+ Tiled 2D lighting for the uber-shader. Each frame the view is cut into a
+ TILE_COLUMNS x TILE_ROWS grid and every light is binned on the CPU into the
+ tiles its radius touches. The lights and the per-tile index lists go up as
+ two small float textures. The fragment shader looks up its own tile and
+ adds only the lights listed there, so the per-fragment cost is capped at
+ MAX_LIGHTS_PER_TILE however many lights the scene has, and there is no
+ extra pass. Without float textures everything draws unlit.
+ */
+class Lighting {
+private:
+    ShaderProgram *program;
+    bool supported = false;
+
+    GLuint light_texture_id = 0;
+    GLuint tile_texture_id = 0;
+
+    GLint enabled_uniform, ambient_uniform;
+    GLint grid_origin_uniform, grid_scale_uniform;
+
+    // CPU staging, kept between frames
+    std::vector<float> light_texels;
+    std::vector<float> tile_texels;
+    std::vector<int> tile_counts;
+
+    float view_left = 0.0f, view_bottom = 0.0f;
+    float tile_width = 1.0f, tile_height = 1.0f;
+
+    static GLuint create_float_texture(int width, int height);
+    void bin(const std::vector<PointLight> &lights);
+
+public:
+    // Keep these in step with the constants in FRAGMENT_UBER_SHADER_SOURCE
+    static const int MAX_LIGHTS = 256;
+    static const int MAX_LIGHTS_PER_TILE = 16;
+    static const int TILE_COLUMNS = 16;
+    static const int TILE_ROWS = 12;
+    static const int SLOTS_PER_TILE = 1 + MAX_LIGHTS_PER_TILE / 4; // a count, then four indices per texel
+
+    Lighting(ShaderProgram *program);
+    ~Lighting();
+
+    // The world rectangle the grid covers this frame
+    void set_view(const Visibility &view);
+
+    // Render thread: lit draws go between these two
+    void begin(const std::vector<PointLight> &lights, glm::vec3 ambient);
+    void end();
+};
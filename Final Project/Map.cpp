@@ -6,58 +6,138 @@
 //
 
 #include "Map.h"
+#include "Utility.h"
+#include "Animation.h"
+#include "GLState.h"
+#include "RenderStats.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include "stb_image.h"
 
-Map::Map(int width, int height, unsigned int *level_data, GLuint texture_id, float tile_size, int tile_count_x, int tile_count_y)
+Map::Map(int width, int height, float tile_size)
 {
     this->width = width;
     this->height = height;
+    this->tile_size = tile_size;
+}
+
+Map::~Map()
+{
+    for (Chunk &chunk : this->chunks) GLState::delete_buffer(chunk.vertex_buffer_id);
+    GLState::delete_buffer(this->index_buffer_id);
+    Utility::delete_texture(this->texture_id);
+}
+
+int Map::add_layer(unsigned int *level_data, const char *tileset_filepath, int tile_count_x, int tile_count_y, bool collidable)
+{
+    if ((int) this->layers.size() >= MAX_LAYERS)
+    {
+        LOG("A map can hold at most " << MAX_LAYERS << " layers.");
+        assert(false);
+    }
     
-    this->level_data = level_data;
-    this->texture_id = texture_id;
+    Layer layer;
+    layer.level_data.assign(level_data, level_data + this->width * this->height);
     
-    this->tile_size = tile_size;
-    this->tile_count_x = tile_count_x;
-    this->tile_count_y = tile_count_y;
+    // Layers drawn from the same tileset share one band of the texture
+    layer.tileset = (int) (std::find(this->tileset_filepaths.begin(), this->tileset_filepaths.end(), tileset_filepath) - this->tileset_filepaths.begin());
+    if (layer.tileset == (int) this->tileset_filepaths.size()) this->tileset_filepaths.push_back(tileset_filepath);
+    
+    layer.tile_count_x = tile_count_x;
+    layer.tile_count_y = tile_count_y;
+    layer.collidable = collidable;
+    layer.u_scale = 1.0f;
+    layer.v_offset = 0.0f;
+    layer.v_scale = 1.0f;
     
-    this->build();
+    this->layers.push_back(layer);
+    return (int) this->layers.size() - 1;
 }
 
-void Map::build()
+void Map::build_texture()
 {
-    for(int y = 0; y < this->height; y++)
+    Utility::delete_texture(this->texture_id);
+    if (this->tileset_filepaths.empty()) return;
+    
+    // STEP 1: Load every tileset; the texture is as wide as the widest and as tall as all of them
+    int tileset_count = (int) this->tileset_filepaths.size();
+    std::vector<unsigned char *> pixels(tileset_count);
+    std::vector<int> widths(tileset_count), heights(tileset_count);
+    int texture_width = 0, texture_height = 0;
+    
+    for (int i = 0; i < tileset_count; i++)
     {
-        for(int x = 0; x < this->width; x++)
+        int number_of_components;
+        pixels[i] = stbi_load(this->tileset_filepaths[i].c_str(), &widths[i], &heights[i], &number_of_components, STBI_rgb_alpha);
+        
+        if (pixels[i] == NULL)
         {
-            int tile = this->level_data[y * this->width + x];
-            
-            if (tile == 0) continue;
-            
-            float u = (float) (tile % this->tile_count_x) / (float) this->tile_count_x;
-            float v = (float) (tile / this->tile_count_x) / (float) this->tile_count_y;
-            
-            float tile_width = 1.0f / (float) this->tile_count_x;
-            float tile_height = 1.0f / (float) this->tile_count_y;
-            
-            float x_offset = -(this->tile_size / 2);
-            float y_offset = (this->tile_size / 2);
+            LOG("Unable to load image. Make sure the path is correct.");
+            assert(false);
+        }
+        
+        texture_width = std::max(texture_width, widths[i]);
+        texture_height += heights[i];
+    }
+    
+    // STEP 2: Stack them, one band per tileset, and tell each layer where its band went
+    std::vector<unsigned char> texture_pixels(texture_width * texture_height * 4, 0);
+    int band_y = 0;
+    
+    for (int i = 0; i < tileset_count; i++)
+    {
+        for (int y = 0; y < heights[i]; y++)
+        {
+            const unsigned char *source = &pixels[i][y * widths[i] * 4];
+            std::copy(source, source + widths[i] * 4, &texture_pixels[(band_y + y) * texture_width * 4]);
+        }
+        
+        for (Layer &layer : this->layers)
+        {
+            if (layer.tileset != i) continue;
             
-            this->vertices.insert(vertices.end(), {
-                x_offset + (this->tile_size * x), y_offset + -this->tile_size * y,
-                x_offset + (this->tile_size * x), y_offset + (-this->tile_size * y) - this->tile_size,
-                x_offset + (this->tile_size * x) + this->tile_size, y_offset + (-this->tile_size * y) - this->tile_size,
-                x_offset + (this->tile_size * x), y_offset + -this->tile_size * y,
-                x_offset + (this->tile_size * x) + this->tile_size, y_offset + (-this->tile_size * y) - tile_size,
-                x_offset + (this->tile_size * x) + this->tile_size, y_offset + -this->tile_size * y
-            });
+            layer.u_scale  = (float) widths[i] / texture_width;
+            layer.v_offset = (float) band_y / texture_height;
+            layer.v_scale  = (float) heights[i] / texture_height;
+        }
+        
+        band_y += heights[i];
+        stbi_image_free(pixels[i]);
+    }
+    
+    // STEP 3: Upload it once; nearest filtering keeps every band from bleeding into the next
+    this->texture_id = Utility::upload_texture(texture_width, texture_height, texture_pixels.data());
+}
+
+void Map::build()
+{
+    for (Chunk &chunk : this->chunks) GLState::delete_buffer(chunk.vertex_buffer_id);
+    this->chunks.clear();
+    this->chunks_built = false;
+    
+    this->chunk_count_x = (this->width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    this->chunk_count_y = (this->height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    this->vertex_count = 0;
+    
+    this->build_texture();
+    
+    // Animated tiles' frames, in the UVs of the texture just built
+    for (Layer &layer : this->layers)
+    {
+        for (TileAnimation &animation : layer.animations)
+        {
+            std::vector<glm::vec4> frame_rectangles;
+            for (unsigned int frame : animation.frames)
+            {
+                frame_rectangles.push_back(glm::vec4(layer.u_scale * (frame % layer.tile_count_x) / layer.tile_count_x,
+                                                     layer.v_offset + layer.v_scale * (frame / layer.tile_count_x) / layer.tile_count_y,
+                                                     layer.u_scale / layer.tile_count_x,
+                                                     layer.v_scale / layer.tile_count_y));
+            }
             
-            this->texture_coordinates.insert(texture_coordinates.end(), {
-                u, v,
-                u, v + (tile_height),
-                u + tile_width, v + (tile_height),
-                u, v,
-                u + tile_width, v + (tile_height),
-                u + tile_width, v
-            });
+            animation.clip = Animation::add_clip(frame_rectangles.data(), (int) frame_rectangles.size());
         }
     }
     
@@ -67,41 +147,419 @@ void Map::build()
     this->bottom_bound = -(this->tile_size * this->height) + (this->tile_size / 2);
 }
 
-void Map::render(ShaderProgram *program)
+void Map::build_chunks()
 {
-    glm::mat4 model_matrix = glm::mat4(1.0f);
-    program->SetModelMatrix(model_matrix);
+    // Chunks are packed from level_data, which already holds every edit so far
+    std::lock_guard<std::mutex> lock(this->edit_mutex);
+    this->dirty_cells.clear();
+    this->chunks_built = true;
     
-    glUseProgram(program->programID);
+    // Two triangles per tile, for as many tiles (of every layer) as a chunk can hold
+    int chunk_tiles = CHUNK_SIZE * CHUNK_SIZE * (int) this->layers.size();
+    if (this->index_buffer_tiles != chunk_tiles)
+    {
+        std::vector<GLushort> indices;
+        indices.reserve(chunk_tiles * 6);
+        
+        for (int tile = 0; tile < chunk_tiles; tile++)
+        {
+            GLushort first = (GLushort) (tile * 4);
+            indices.insert(indices.end(), { first, (GLushort) (first + 1), (GLushort) (first + 2),
+                                            first, (GLushort) (first + 2), (GLushort) (first + 3) });
+        }
+        
+        if (this->index_buffer_id == 0) glGenBuffers(1, &this->index_buffer_id);
+        GLState::bind_element_buffer(this->index_buffer_id);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+        this->index_buffer_tiles = chunk_tiles;
+    }
     
-    glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, this->vertices.data());
-    glEnableVertexAttribArray(program->positionAttribute);
-    glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, this->texture_coordinates.data());
-    glEnableVertexAttribArray(program->texCoordAttribute);
+    // Chunks are stored row by row: chunk (cx, cy) is chunks[cy * chunk_count_x + cx]
+    for (int chunk_y = 0; chunk_y < this->chunk_count_y; chunk_y++)
+    {
+        for (int chunk_x = 0; chunk_x < this->chunk_count_x; chunk_x++)
+        {
+            Chunk chunk;
+            chunk.first_x = chunk_x * CHUNK_SIZE;
+            chunk.first_y = chunk_y * CHUNK_SIZE;
+            chunk.width  = std::min(CHUNK_SIZE, this->width - chunk.first_x);
+            chunk.height = std::min(CHUNK_SIZE, this->height - chunk.first_y);
+            
+            // Local tile corner (x, y) lands on the world position of that corner
+            chunk.model_matrix = glm::translate(glm::mat4(1.0f), glm::vec3(this->tile_size * (chunk.first_x - 0.5f),
+                                                                          -this->tile_size * (chunk.first_y - 0.5f),
+                                                                          0.0f));
+            chunk.model_matrix = glm::scale(chunk.model_matrix, glm::vec3(this->tile_size, -this->tile_size, 1.0f));
+            
+            this->build_chunk(chunk);
+            this->chunks.push_back(chunk);
+        }
+    }
+}
+
+void Map::build_chunk(Chunk &chunk)
+{
+    int layer_count = (int) this->layers.size();
+    
+    // CPU-side staging only; once it is on the GPU we let it go
+    std::vector<TileVertex> vertices;
     
-    glBindTexture(GL_TEXTURE_2D, this->texture_id);
+    chunk.column_first_slot.assign(chunk.width + 1, 0);
+    chunk.cell_slots.assign(chunk.width * chunk.height * layer_count, -1);
+    chunk.column_tiles.assign(chunk.width, 0);
+    this->vertex_count -= chunk.slot_count * 4;
     
-    glDrawArrays(GL_TRIANGLES, 0, (int) this->vertices.size() / 2);
-    glDisableVertexAttribArray(program->positionAttribute);
-    glDisableVertexAttribArray(program->texCoordAttribute);
+    // Column-major, so any run of visible columns is one contiguous range of
+    // slots; within a cell the layers go back to front, so they stack right.
+    // Empty tiles get no slot, so a sparse map costs only what it shows
+    int slot = 0;
+    for(int local_x = 0; local_x < chunk.width; local_x++)
+    {
+        chunk.column_first_slot[local_x] = slot;
+        
+        for(int local_y = 0; local_y < chunk.height; local_y++)
+        {
+            int x = chunk.first_x + local_x, y = chunk.first_y + local_y;
+            
+            for (int layer = 0; layer < layer_count; layer++)
+            {
+                if (this->layers[layer].level_data[y * this->width + x] == 0) continue;
+                
+                chunk.cell_slots[(local_x * chunk.height + local_y) * layer_count + layer] = slot;
+                vertices.resize((slot + 1) * 4);
+                this->write_tile(layer, x, y, &vertices[slot * 4]);
+                chunk.column_tiles[local_x]++;
+                slot++;
+            }
+        }
+    }
+    chunk.column_first_slot[chunk.width] = slot;
+    chunk.slot_count = slot;
+    chunk.slot_filled.assign(slot, true);
+    
+    this->vertex_count += slot * 4;
+    
+    if (chunk.vertex_buffer_id == 0) glGenBuffers(1, &chunk.vertex_buffer_id);
+    
+    GLState::bind_array_buffer(chunk.vertex_buffer_id);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(TileVertex), vertices.data(), GL_STATIC_DRAW);
 }
 
-bool Map::is_solid(glm::vec3 position, float *penetration_x, float *penetration_y)
+void Map::write_tile(int layer, int x, int y, TileVertex *vertices) const
 {
-    *penetration_x = 0;
-    *penetration_y = 0;
+    const Layer &source = this->layers[layer];
+    int tile = source.level_data[y * this->width + x];
+    
+    GLubyte left = (GLubyte) (x % CHUNK_SIZE), right = (GLubyte) (x % CHUNK_SIZE + 1);
+    GLubyte top  = (GLubyte) (y % CHUNK_SIZE), bottom = (GLubyte) (y % CHUNK_SIZE + 1);
     
+    // A broken tile collapses to a point, which the rasteriser throws away
+    if (tile == 0)
+    {
+        for (int i = 0; i < 4; i++) vertices[i] = { 0, 0, left, top, 0, 0 };
+        return;
+    }
+    
+    // Animated tiles span the unit square; the shader moves it onto the current frame.
+    // A clip that didn't fit in the shader's tables leaves the tile still
+    for (const TileAnimation &animation : source.animations)
+    {
+        if (animation.tile != (unsigned int) tile || animation.clip == 0) continue;
+        
+        GLubyte clip = (GLubyte) animation.clip, rate = (GLubyte) animation.frames_per_second;
+        vertices[0] = { 0,     0,     left,  top,    clip, rate };
+        vertices[1] = { 0,     65535, left,  bottom, clip, rate };
+        vertices[2] = { 65535, 65535, right, bottom, clip, rate };
+        vertices[3] = { 65535, 0,     right, top,    clip, rate };
+        return;
+    }
+    
+    // Tile corners in this layer's band of the texture, scaled to the full 16-bit range
+    int column = tile % source.tile_count_x, row = tile / source.tile_count_x;
+    
+    GLushort u_left   = (GLushort) (65535.0f * source.u_scale * column       / source.tile_count_x + 0.5f);
+    GLushort u_right  = (GLushort) (65535.0f * source.u_scale * (column + 1) / source.tile_count_x + 0.5f);
+    GLushort v_top    = (GLushort) (65535.0f * (source.v_offset + source.v_scale * row       / source.tile_count_y) + 0.5f);
+    GLushort v_bottom = (GLushort) (65535.0f * (source.v_offset + source.v_scale * (row + 1) / source.tile_count_y) + 0.5f);
+    
+    vertices[0] = { u_left,  v_top,    left,  top,    0, 0 };
+    vertices[1] = { u_left,  v_bottom, left,  bottom, 0, 0 };
+    vertices[2] = { u_right, v_bottom, right, bottom, 0, 0 };
+    vertices[3] = { u_right, v_top,    right, top,    0, 0 };
+}
+
+void Map::set_tile(int x, int y, unsigned int tile, int layer)
+{
+    if (x < 0 || x >= this->width || y < 0 || y >= this->height) return;
+    if (layer < 0 || layer >= (int) this->layers.size()) return;
+    
+    std::lock_guard<std::mutex> lock(this->edit_mutex);
+    std::vector<unsigned int> &level_data = this->layers[layer].level_data;
+    if (level_data[y * this->width + x] == tile) return;
+    
+    // Collision reads level_data directly, so the cell is solid (or not) from the next probe on
+    level_data[y * this->width + x] = tile;
+    this->dirty_cells.push_back(layer * this->width * this->height + y * this->width + x);
+    this->revision++;
+}
+
+void Map::animate_tile(int layer, unsigned int tile, const unsigned int *frames, int frame_count, int frames_per_second)
+{
+    if (layer < 0 || layer >= (int) this->layers.size()) return;
+    
+    TileAnimation animation;
+    animation.tile = tile;
+    animation.frames.assign(frames, frames + frame_count);
+    animation.frames_per_second = std::min(std::max(frames_per_second, 0), 255);
+    
+    this->layers[layer].animations.push_back(animation);
+}
+
+void Map::set_breakable(unsigned int tile)
+{
+    if (tile >= this->breakable_tiles.size()) this->breakable_tiles.resize(tile + 1, false);
+    this->breakable_tiles[tile] = true;
+}
+
+bool Map::break_tile(glm::vec3 position)
+{
+    int tile_x, tile_y;
+    if (!this->find_cell(position, &tile_x, &tile_y)) return false;
+    
+    // Only something the player can actually bump into can break; the front-most layer goes first
+    for (int layer = (int) this->layers.size() - 1; layer >= 0; layer--)
+    {
+        if (!this->layers[layer].collidable) continue;
+        if (!this->is_breakable(this->layers[layer].level_data[tile_y * this->width + tile_x])) continue;
+        
+        this->set_tile(tile_x, tile_y, 0, layer);
+        return true;
+    }
+    
+    return false;
+}
+
+void Map::patch_dirty_cells()
+{
+    std::lock_guard<std::mutex> lock(this->edit_mutex);
+    
+    // Each edit of a tile that has a slot rewrites only its own 4 vertices, wherever in the level it is
+    TileVertex vertices[4];
+    std::vector<Chunk *> repacked_chunks;
+    
+    int layer_count = (int) this->layers.size();
+    
+    for (int dirty_cell : this->dirty_cells)
+    {
+        int layer = dirty_cell / (this->width * this->height);
+        int cell  = dirty_cell % (this->width * this->height);
+        int x = cell % this->width;
+        int y = cell / this->width;
+        
+        Chunk &chunk = this->chunks[(y / CHUNK_SIZE) * this->chunk_count_x + (x / CHUNK_SIZE)];
+        int slot = chunk.cell_slots[((x - chunk.first_x) * chunk.height + (y - chunk.first_y)) * layer_count + layer];
+        
+        // A tile placed where the chunk had nothing needs room in the middle of it
+        if (slot < 0)
+        {
+            if (std::find(repacked_chunks.begin(), repacked_chunks.end(), &chunk) == repacked_chunks.end()) repacked_chunks.push_back(&chunk);
+            continue;
+        }
+        
+        this->write_tile(layer, x, y, vertices);
+        
+        bool filled = this->layers[layer].level_data[cell] != 0;
+        if (filled != chunk.slot_filled[slot])
+        {
+            chunk.slot_filled[slot] = filled;
+            chunk.column_tiles[x - chunk.first_x] += filled ? 1 : -1;
+        }
+        
+        GLState::bind_array_buffer(chunk.vertex_buffer_id);
+        glBufferSubData(GL_ARRAY_BUFFER, slot * sizeof(vertices), sizeof(vertices), vertices);
+    }
+    
+    // Repacking rewrites every slot from level_data, so earlier patches to these chunks are kept
+    for (Chunk *chunk : repacked_chunks) this->build_chunk(*chunk);
+    
+    this->dirty_cells.clear();
+}
+
+// A default Visibility is unbounded, and casting its ±inf straight to int is
+// undefined, so the cell is clamped while it is still a float
+static int clamp_cell(float cell, int low, int high)
+{
+    return (int) std::min(std::max(floorf(cell), (float) low), (float) high);
+}
+
+bool Map::find_visible_cells(Visibility *visibility, int *first_column, int *last_column, int *first_row, int *last_row) const
+{
+    // Work out the visible tile rectangle; everything else is never looked at,
+    // so the cost per frame depends on the view and not on the level size
+    *first_column = 0;
+    *last_column = this->width - 1;
+    *first_row = 0;
+    *last_row = this->height - 1;
+    
+    if (visibility != NULL)
+    {
+        // One past either end still means nothing is visible on that side
+        *first_column = clamp_cell((visibility->left + (this->tile_size / 2)) / this->tile_size, 0, this->width);
+        *last_column  = clamp_cell((visibility->right + (this->tile_size / 2)) / this->tile_size, -1, this->width - 1);
+        *first_row    = clamp_cell(((this->tile_size / 2) - visibility->top) / this->tile_size, 0, this->height);
+        *last_row     = clamp_cell(((this->tile_size / 2) - visibility->bottom) / this->tile_size, -1, this->height - 1);
+        
+        int columns_drawn = std::max(0, *last_column - *first_column + 1);
+        visibility->columns_drawn += columns_drawn;
+        visibility->columns_culled += this->width - columns_drawn;
+    }
+    
+    return *first_column <= *last_column && *first_row <= *last_row;
+}
+
+void Map::render(ShaderProgram *program, Visibility *visibility)
+{
+    if (!this->chunks_built) this->build_chunks();
+    this->patch_dirty_cells();
+    
+    GLState::use_program(program->programID);
+    
+    if (this->vertex_count == 0) return;
+    
+    int first_column, last_column, first_row, last_row;
+    if (!this->find_visible_cells(visibility, &first_column, &last_column, &first_row, &last_row)) return;
+    
+    GLState::bind_texture(this->texture_id);
+    GLState::bind_element_buffer(this->index_buffer_id);
+    if (program != this->program)
+    {
+        this->program = program;
+        this->animation_attribute = glGetAttribLocation(program->programID, "animation");
+    }
+    
+    GLState::use_attributes({ (GLint) program->positionAttribute, (GLint) program->texCoordAttribute, this->animation_attribute });
+    
+    for (int chunk_y = first_row / CHUNK_SIZE; chunk_y <= last_row / CHUNK_SIZE; chunk_y++)
+    {
+        for (int chunk_x = first_column / CHUNK_SIZE; chunk_x <= last_column / CHUNK_SIZE; chunk_x++)
+        {
+            Chunk &chunk = this->chunks[chunk_y * this->chunk_count_x + chunk_x];
+            
+            int chunk_first_column = std::max(first_column, chunk.first_x) - chunk.first_x;
+            int chunk_last_column  = std::min(last_column, chunk.first_x + chunk.width - 1) - chunk.first_x;
+            
+            this->render_chunk(program, chunk, chunk_first_column, chunk_last_column);
+        }
+    }
+}
+
+void Map::render_chunk(ShaderProgram *program, Chunk &chunk, int first_column, int last_column)
+{
+    // Every layer of the visible columns in one draw
+    int first_tile = chunk.column_first_slot[first_column];
+    int visible_tile_count = chunk.column_first_slot[last_column + 1] - first_tile;
+    if (visible_tile_count == 0) return;
+    
+    GLState::set_model_matrix(program, chunk.model_matrix);
+    
+    // Attribute pointers are offsets into the buffer, not client memory.
+    // Positions stay integers (the model matrix scales them); UVs are normalised
+    GLsizei stride = sizeof(TileVertex);
+    GLState::bind_array_buffer(chunk.vertex_buffer_id);
+    
+    glVertexAttribPointer(program->texCoordAttribute, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void *) offsetof(TileVertex, u));
+    glVertexAttribPointer(program->positionAttribute, 2, GL_UNSIGNED_BYTE, GL_FALSE, stride, (void *) offsetof(TileVertex, x));
+    
+    // Only (clip, rate) are stored; the start time and start frame read back as
+    // 0 and 1, the same for every tile, so all tiles of a clip stay in step
+    if (this->animation_attribute >= 0)
+    {
+        glVertexAttribPointer(this->animation_attribute, 2, GL_UNSIGNED_BYTE, GL_FALSE, stride, (void *) offsetof(TileVertex, clip));
+    }
+    
+    glDrawElements(GL_TRIANGLES, visible_tile_count * 6, GL_UNSIGNED_SHORT, (void *) (first_tile * 6 * sizeof(GLushort)));
+    
+    // Broken tiles' collapsed quads go through the draw but show nothing
+    int drawn_tile_count = 0;
+    for (int column = first_column; column <= last_column; column++) drawn_tile_count += chunk.column_tiles[column];
+    RenderStats::count_draw(drawn_tile_count * 4);
+}
+
+void Map::get_sprites(Visibility *visibility, std::vector<SpriteBatch::Sprite> &sprites)
+{
+    sprites.clear();
+    
+    int first_column, last_column, first_row, last_row;
+    if (!this->find_visible_cells(visibility, &first_column, &last_column, &first_row, &last_row)) return;
+    
+    // Straight from level_data, so edits need no patching
+    std::lock_guard<std::mutex> lock(this->edit_mutex);
+    
+    // Column by column with each cell's layers back to front, the order the chunks draw in
+    for (int x = first_column; x <= last_column; x++)
+    {
+        for (int y = first_row; y <= last_row; y++)
+        {
+            glm::vec3 position(this->tile_size * x, -this->tile_size * y, 0.0f);
+            glm::vec3 size(this->tile_size, this->tile_size, 1.0f);
+            
+            for (const Layer &layer : this->layers)
+            {
+                unsigned int tile = layer.level_data[y * this->width + x];
+                if (tile == 0) continue;
+                
+                // Animated tiles span the unit square, as in write_tile(); start time 0 and start frame 1 keep them in step
+                const TileAnimation *animation = NULL;
+                for (const TileAnimation &candidate : layer.animations) if (candidate.tile == tile && candidate.clip != 0) animation = &candidate;
+                
+                if (animation != NULL)
+                {
+                    sprites.push_back({ this->texture_id, position, size, 0.0f, 0.0f, 1.0f, 1.0f, glm::vec4(1.0f),
+                                        glm::vec4((float) animation->clip, (float) animation->frames_per_second, 0.0f, 1.0f) });
+                    continue;
+                }
+                
+                int column = tile % layer.tile_count_x, row = tile / layer.tile_count_x;
+                sprites.push_back({ this->texture_id, position, size,
+                                    layer.u_scale * column / layer.tile_count_x,
+                                    layer.v_offset + layer.v_scale * row / layer.tile_count_y,
+                                    layer.u_scale / layer.tile_count_x,
+                                    layer.v_scale / layer.tile_count_y,
+                                    glm::vec4(1.0f), glm::vec4(0.0f) });
+            }
+        }
+    }
+}
+
+bool Map::find_cell(glm::vec3 position, int *tile_x, int *tile_y) const
+{
     if (position.x < this->left_bound || position.x > this->right_bound) return false;
     if (position.y > this->top_bound || position.y < this->bottom_bound) return false;
     
-    int tile_x = floor((position.x + (this->tile_size / 2)) / this->tile_size);
-    int tile_y = -(ceil(position.y - (this->tile_size / 2))) / this->tile_size;
+    *tile_x = floor((position.x + (this->tile_size / 2)) / this->tile_size);
+    *tile_y = -(ceil(position.y - (this->tile_size / 2))) / this->tile_size;
     
-    if (tile_x < 0 || tile_x >= this->width) return false;
-    if (tile_y < 0 || tile_y >= this->height) return false;
+    if (*tile_x < 0 || *tile_x >= this->width) return false;
+    if (*tile_y < 0 || *tile_y >= this->height) return false;
     
-    int tile = level_data[tile_y * this->width + tile_x];
-    if (tile == 0) return false;
+    return true;
+}
+
+bool Map::is_solid(glm::vec3 position, float *penetration_x, float *penetration_y)
+{
+    *penetration_x = 0;
+    *penetration_y = 0;
+    
+    int tile_x, tile_y;
+    if (!this->find_cell(position, &tile_x, &tile_y)) return false;
+    
+    // Decoration layers are drawn but never collided with
+    bool solid = false;
+    for (const Layer &layer : this->layers)
+    {
+        if (layer.collidable && layer.level_data[tile_y * this->width + tile_x] != 0) solid = true;
+    }
+    if (!solid) return false;
     
     float tile_center_x = (tile_x * this->tile_size);
     float tile_center_y = -(tile_y * this->tile_size);
@@ -10,6 +10,8 @@
 #include <GL/glew.h>
 #endif
 #define GL_GLEXT_PROTOTYPES 1
+#include <mutex>
+#include <string>
 #include <vector>
 #include <math.h>
 #include <SDL.h>
@@ -18,44 +20,185 @@
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
+#include "SpriteBatch.h"
+#include "Visibility.h"
 
+/**
+ A tile map made of up to MAX_LAYERS stacked layers (backdrop, terrain,
+ foreground...), each laid out on the same grid with its own tileset. Every
+ layer's tileset is packed into one texture and every layer is written into
+ the same chunk meshes, so the whole map is still one bind and one draw per
+ visible chunk however many layers it has. Only collidable layers are solid.
+ */
 class Map{
+public:
+    static const int CHUNK_SIZE = 32;
+    
+    // 4 vertices per tile per layer must stay addressable by 16-bit indices
+    static const int MAX_LAYERS = 16;
+    
 private:
     int width;
     int height;
     
-    unsigned int *level_data;
-    GLuint texture_id;
+    // A tile id that cycles through other tiles of its layer's tileset. The
+    // shader does the cycling, so nothing is rebuilt or re-uploaded to animate
+    struct TileAnimation
+    {
+        unsigned int tile;
+        std::vector<unsigned int> frames;
+        int frames_per_second;
+        int clip = 0; // Animation clip id, made by build()
+    };
+    
+    struct Layer
+    {
+        // Our own copy of the layout, so breaking tiles never edits the level's
+        // source array and a re-initialised level starts intact
+        std::vector<unsigned int> level_data;
+        
+        int tileset;    // index into tileset_filepaths
+        int tile_count_x;
+        int tile_count_y;
+        bool collidable;
+        
+        // Where this layer's tileset landed in the shared texture, in UV space
+        float u_scale, v_offset, v_scale;
+        
+        std::vector<TileAnimation> animations;
+    };
+    
+    std::vector<Layer> layers;
+    
+    // Each distinct tileset once, however many layers share it
+    std::vector<std::string> tileset_filepaths;
+    
+    // Every tileset stacked top to bottom in one texture. GL 2.1 and
+    // GLSL 1.20 have no texture arrays, so the layer index picks the band a
+    // tile samples from when its UVs are written instead of in the shader
+    GLuint texture_id = 0;
     
     float tile_size;
-    int tile_count_x;
-    int tile_count_y;
     
-    std::vector<float> vertices;
-    std::vector<float> texture_coordinates;
+    // 8 bytes per vertex, 4 vertices per tile. Positions are chunk-local tile
+    // corners (the chunk's model matrix places and scales them) and UVs are
+    // normalised 16-bit, so a tile costs 32 bytes instead of 96. Animated tiles
+    // carry their clip and rate, and unit UVs the clip's frame places
+    struct TileVertex
+    {
+        GLushort u, v;
+        GLubyte x, y;
+        GLubyte clip, frames_per_second;
+    };
+    
+    // The level is split into CHUNK_SIZE x CHUNK_SIZE tile chunks, each with its
+    // own static buffer, so drawing and rebuilding only touch the chunks involved
+    struct Chunk
+    {
+        int first_x, first_y;
+        int width, height;
+        
+        // Lives on the GPU once built; drawn through the shared index buffer.
+        // Only tiles that exist get a slot, packed column by column with a
+        // cell's layers back to front, so any run of columns is one range
+        GLuint vertex_buffer_id = 0;
+        glm::mat4 model_matrix;
+        
+        // column_first_slot[x] is where local column x starts (one more entry
+        // ends the last column), and cell_slots[(x * height + y) * layer count + layer]
+        // is that tile's slot, or -1 for a cell that was empty when the chunk
+        // was built. A tile broken since keeps its slot as a zero-area quad, so
+        // an edit only rewrites its own four vertices; only filling a cell that
+        // had no slot repacks the chunk
+        std::vector<int> column_first_slot;
+        std::vector<int> cell_slots;
+        int slot_count = 0;
+        
+        // Slots still holding a tile, per slot and per column, so the stats count what is really drawn
+        std::vector<bool> slot_filled;
+        std::vector<int> column_tiles;
+    };
+    
+    // Made by the first render(), on the GL thread, so a map only ever drawn as
+    // sprites (see get_sprites()) never needs a context
+    std::vector<Chunk> chunks;
+    bool chunks_built = false;
+    
+    // Tile i of any chunk is vertices 4i..4i+3, so one index buffer serves them all
+    GLuint index_buffer_id = 0;
+    int index_buffer_tiles = 0;
+    
+    int chunk_count_x = 0;
+    int chunk_count_y = 0;
+    int vertex_count = 0;
+    
+    // Tile ids that break when hit from below
+    std::vector<bool> breakable_tiles;
+    
+    // set_tile() may run on the simulation thread, so it only records which
+    // cells changed (as layer * width * height + cell); the GL thread patches
+    // them at the start of render()
+    std::mutex edit_mutex;
+    std::vector<int> dirty_cells;
+    
+    // Bumped by every edit, so a cache of the map (see StaticLayer) can tell it is out of date
+    int revision = 0;
+    
+    // The shader's animation attribute, looked up whenever the program changes
+    ShaderProgram *program = NULL;
+    GLint animation_attribute = -1;
+    
+    void build_texture();
+    void build_chunks();
+    void build_chunk(Chunk &chunk);    // (re)packs the chunk's tiles and uploads them
+    void write_tile(int layer, int x, int y, TileVertex *vertices) const;
+    void patch_dirty_cells();
+    bool find_cell(glm::vec3 position, int *tile_x, int *tile_y) const;
+    bool find_visible_cells(Visibility *visibility, int *first_column, int *last_column, int *first_row, int *last_row) const;
+    void render_chunk(ShaderProgram *program, Chunk &chunk, int first_column, int last_column);
     
     float left_bound, right_bound, top_bound, bottom_bound;
     
 public:
-    Map(int width, int height, unsigned int *level_data, GLuint texture_id, float tile_size, int tile_count_x, int tile_count_y);
+    Map(int width, int height, float tile_size);
+    ~Map();
+    
+    // Layers draw in the order they are added, first at the back. Call build() once they are all in
+    int add_layer(unsigned int *level_data, const char *tileset_filepath, int tile_count_x, int tile_count_y, bool collidable = true);
     
     void build();
-    void render(ShaderProgram *program);
+    void render(ShaderProgram *program, Visibility *visibility = NULL);
+    
+    // The same tiles render() would draw, one sprite each, back to front; for renderers with no chunk buffers
+    void get_sprites(Visibility *visibility, std::vector<SpriteBatch::Sprite> &sprites);
     bool is_solid(glm::vec3 position, float *penetration_x, float *penetration_y);
     
+    // No default layer: layer 0 is often a backdrop, not the terrain
+    void set_tile(int x, int y, unsigned int tile, int layer);
+    
+    // Every cell of that layer holding tile shows frames[0], frames[1]... in turn,
+    // frames_per_second of them a second. Call before build()
+    void animate_tile(int layer, unsigned int tile, const unsigned int *frames, int frame_count, int frames_per_second);
+    void set_breakable(unsigned int tile);
+    bool break_tile(glm::vec3 position);
+    bool const is_breakable(unsigned int tile) const {return tile < this->breakable_tiles.size() && this->breakable_tiles[tile];}
+    unsigned int const get_tile(int x, int y, int layer = 0) const {return this->layers[layer].level_data[y * this->width + x];}
+    
     //Getter
     int const get_width() const {return this->width;}
     int const get_height() const {return this->height;}
+    int const get_layer_count() const {return (int) this->layers.size();}
     
-    unsigned int* const get_level_data() const {return this->level_data;}
+    const unsigned int* get_level_data(int layer = 0) const {return this->layers[layer].level_data.data();}
     GLuint        const get_texture_id() const {return this->texture_id;}
     
     float const get_tile_size() const {return this->tile_size;}
-    int const get_tile_count_x() {return this->tile_count_x;}
-    int const get_tile_count_y() {return this->tile_count_y;}
+    int const get_tile_count_x(int layer = 0) const {return this->layers[layer].tile_count_x;}
+    int const get_tile_count_y(int layer = 0) const {return this->layers[layer].tile_count_y;}
     
-    std::vector<float> const get_vertices()             const {return this->vertices;           }
-    std::vector<float> const get_texuture_coordinates() const {return this->texture_coordinates;}
+    int const get_chunk_count()  const {return (int) this->chunks.size();}
+    int const get_vertex_count() const {return this->vertex_count;       }
+    int const get_revision()     const {return this->revision;           }
     
     float const get_left_bound() const {return this->left_bound;    }
     float const get_right_bound() const {return this->right_bound;  }
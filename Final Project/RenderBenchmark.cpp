@@ -0,0 +1,231 @@
+#include "RenderBenchmark.h"
+#include "Utility.h"
+#include "GLRenderer.h"
+#include "Map.h"
+#include "SoftwareRenderer.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include "stb_image.h"
+
+// The game's camera: ten units across, centred on the middle of the map
+static const float VIEW_WIDTH = 10.0f, VIEW_HEIGHT = 7.5f;
+static const int MAP_WIDTH = 10, MAP_HEIGHT = 8;
+static const glm::vec3 VIEW_CENTRE((MAP_WIDTH - 1) / 2.0f, -(MAP_HEIGHT - 1) / 2.0f, 0.0f);
+
+RenderBenchmark::Textures RenderBenchmark::load_textures(Renderer *renderer)
+{
+    auto load = [renderer](const char *filepath) {
+        int width, height, number_of_components;
+        unsigned char *pixels = stbi_load(filepath, &width, &height, &number_of_components, STBI_rgb_alpha);
+
+        if (pixels == NULL)
+        {
+            LOG("Unable to load image. Make sure the path is correct.");
+            assert(false);
+            return (GLuint) 0;
+        }
+
+        GLuint texture_id = renderer->create_texture(width, height, pixels);
+        stbi_image_free(pixels);
+        return texture_id;
+    };
+
+    Textures textures;
+    textures.player  = load("assets/texture/fireboy.png");
+    textures.monster = load("assets/texture/monster.png");
+    textures.fire    = load("assets/texture/fire.png");
+    return textures;
+}
+
+Map *RenderBenchmark::build_map()
+{
+    // STEP 1: A backdrop over every cell, and terrain from another tileset on top of it,
+    // so the frame goes through the multi-layer path with two bands in the map texture
+    std::vector<unsigned int> backdrop(MAP_WIDTH * MAP_HEIGHT), terrain(MAP_WIDTH * MAP_HEIGHT, 0);
+    for (int y = 0; y < MAP_HEIGHT; y++)
+    {
+        for (int x = 0; x < MAP_WIDTH; x++)
+        {
+            backdrop[y * MAP_WIDTH + x] = 1 + (x + y) % 3;
+            if (y >= MAP_HEIGHT - 2 || (y == 3 && x >= 2 && x <= 6)) terrain[y * MAP_WIDTH + x] = 1 + (x + y) % 3;
+        }
+    }
+
+    // STEP 2: The map keeps its own copies
+    Map *map = new Map(MAP_WIDTH, MAP_HEIGHT, 1.0f);
+    map->add_layer(backdrop.data(), "assets/texture/greenzone_tileset.png", 4, 1, false);
+    map->add_layer(terrain.data(), "assets/texture/tileset.png", 4, 1);
+    map->build();
+    return map;
+}
+
+void RenderBenchmark::build_frame(const Textures &textures, int sprite_count, std::vector<SpriteBatch::Sprite> &sprites)
+{
+    // Our own generator, so every machine draws the same frame
+    unsigned int seed = 1;
+    auto random = [&seed](float low, float high) {
+        seed = seed * 1664525u + 1013904223u;
+        return low + (high - low) * (float) (seed >> 8) / (float) (1u << 24);
+    };
+
+    sprites.clear();
+
+    // STEP 1: Characters from their sprite sheets, and translucent tinted fire, over the map
+    for (int i = 0; i < sprite_count; i++)
+    {
+        glm::vec3 position = VIEW_CENTRE + glm::vec3(random(-VIEW_WIDTH / 2.0f, VIEW_WIDTH / 2.0f), random(-VIEW_HEIGHT / 2.0f, VIEW_HEIGHT / 2.0f), 0.0f);
+        glm::vec3 size(random(0.6f, 1.4f));
+        int kind = (int) random(0.0f, 3.0f);
+
+        if (kind == 0)
+        {
+            int frame = (int) random(0.0f, 16.0f);
+            sprites.push_back({ textures.player, position, size, (frame % 4) * 0.25f, (frame / 4) * 0.25f, 0.25f, 0.25f, glm::vec4(1.0f), glm::vec4(0.0f) });
+        }
+        else if (kind == 1)
+        {
+            sprites.push_back({ textures.monster, position, size, 0.0f, 0.0f, 1.0f, 1.0f, glm::vec4(1.0f), glm::vec4(0.0f) });
+        }
+        else
+        {
+            sprites.push_back({ textures.fire, position, size, 0.0f, 0.0f, 1.0f, 1.0f, glm::vec4(1.0f, 0.8f, 0.6f, 0.7f), glm::vec4(0.0f) });
+        }
+    }
+
+    // STEP 2: A dark panel over the top, like the stats overlay
+    sprites.push_back({ 0, VIEW_CENTRE + glm::vec3(0.0f, 3.0f, 0.0f), glm::vec3(VIEW_WIDTH, 1.5f, 1.0f), 0.0f, 0.0f, 1.0f, 1.0f, glm::vec4(0.0f, 0.0f, 0.0f, 0.6f), glm::vec4(0.0f) });
+}
+
+void RenderBenchmark::draw_frame(Renderer *renderer, Map *map, const std::vector<SpriteBatch::Sprite> &sprites)
+{
+    glm::mat4 view_matrix = glm::translate(glm::mat4(1.0f), -VIEW_CENTRE);
+    glm::mat4 projection_matrix = glm::ortho(-VIEW_WIDTH / 2.0f, VIEW_WIDTH / 2.0f, -VIEW_HEIGHT / 2.0f, VIEW_HEIGHT / 2.0f, -1.0f, 1.0f);
+
+    renderer->begin_frame(view_matrix, projection_matrix, glm::vec4(0.1922f, 0.549f, 0.9059f, 1.0f));
+
+    // The map first, then everything on top, the way the queue layers them
+    renderer->draw_map(map, NULL);
+    renderer->draw_sprites(sprites.data(), (int) sprites.size() - 1);
+    renderer->draw_sprites(&sprites.back(), 1);
+
+    renderer->end_frame();
+}
+
+void RenderBenchmark::run(Renderer *renderer, std::vector<unsigned char> &frame)
+{
+    // The map's texture goes up through Utility, so point that at this renderer too
+    Renderer *previous_texture_renderer = Utility::get_texture_renderer();
+    Utility::set_texture_renderer(renderer);
+
+    Textures textures = load_textures(renderer);
+    Map *map = build_map();
+    std::vector<SpriteBatch::Sprite> sprites;
+
+    const int sprite_counts[] = { 100, 1000, 10000 };
+
+    LOG(renderer->get_name() << ", " << renderer->get_width() << "x" << renderer->get_height() << ":");
+
+    for (int sprite_count : sprite_counts)
+    {
+        build_frame(textures, sprite_count, sprites);
+
+        // Roughly the same amount of drawing at every size
+        int repetitions = std::max(5, 20000 / sprite_count);
+
+        draw_frame(renderer, map, sprites);
+        if (sprite_count == sprite_counts[0]) renderer->read_pixels(frame);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < repetitions; i++) draw_frame(renderer, map, sprites);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        double frame_ms = std::chrono::duration<double, std::milli>(end - start).count() / repetitions;
+        LOG("    " << sprite_count << " sprites: " << frame_ms << " ms per frame, "
+            << (int) (sprites.size() / frame_ms) << " sprites per ms");
+    }
+
+    delete map;
+    renderer->delete_texture(textures.player);
+    renderer->delete_texture(textures.monster);
+    renderer->delete_texture(textures.fire);
+
+    Utility::set_texture_renderer(previous_texture_renderer);
+}
+
+int RenderBenchmark::count_differences(const std::vector<unsigned char> &a, const std::vector<unsigned char> &b, int *max_difference)
+{
+    int differences = 0;
+    *max_difference = 0;
+
+    for (size_t pixel = 0; pixel + 4 <= std::min(a.size(), b.size()); pixel += 4)
+    {
+        int difference = 0;
+        for (int c = 0; c < 4; c++) difference = std::max(difference, abs((int) a[pixel + c] - (int) b[pixel + c]));
+
+        if (difference > 0) differences++;
+        *max_difference = std::max(*max_difference, difference);
+    }
+
+    return differences;
+}
+
+void RenderBenchmark::write_ppm(const char *filepath, const std::vector<unsigned char> &pixels, int width, int height)
+{
+    FILE *file = fopen(filepath, "wb");
+    if (file == NULL)
+    {
+        LOG("Unable to write " << filepath << ".");
+        return;
+    }
+
+    // Binary PPM is RGB only; the frame is opaque anyway
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    for (int i = 0; i < width * height; i++) fwrite(&pixels[i * 4], 1, 3, file);
+    fclose(file);
+
+    LOG("Wrote " << filepath);
+}
+
+void RenderBenchmark::run_headless(int width, int height, const char *image_filepath)
+{
+    SoftwareRenderer renderer(width, height);
+    renderer.set_time(0.0f);
+
+    // STEP 1: Both span fillers over the same frames
+    std::vector<unsigned char> simd_frame, scalar_frame;
+    SoftwareRenderer::set_simd(true);
+    run(&renderer, simd_frame);
+    SoftwareRenderer::set_simd(false);
+    run(&renderer, scalar_frame);
+    SoftwareRenderer::set_simd(true);
+
+    // STEP 2: They must agree exactly
+    int max_difference;
+    int differences = count_differences(simd_frame, scalar_frame, &max_difference);
+    LOG("simd against scalar: " << differences << " pixels differ, by at most " << max_difference);
+
+    if (image_filepath != NULL) write_ppm(image_filepath, simd_frame, width, height);
+}
+
+void RenderBenchmark::run_gl(ShaderProgram *program, int width, int height, const char *image_filepath)
+{
+    std::vector<unsigned char> gl_frame, software_frame;
+
+    GLRenderer gl_renderer(program, width, height);
+    run(&gl_renderer, gl_frame);
+
+    SoftwareRenderer software_renderer(width, height);
+    software_renderer.set_time(0.0f);
+    run(&software_renderer, software_frame);
+
+    // Edges can land on different pixels; anything beyond a scattering is a real difference
+    int max_difference;
+    int differences = count_differences(gl_frame, software_frame, &max_difference);
+    LOG("gl against software: " << differences << " of " << width * height << " pixels differ, by at most " << max_difference);
+
+    if (image_filepath != NULL) write_ppm(image_filepath, gl_frame, width, height);
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include "Renderer.h"
+#include "ShaderProgram.h"
+
+/**
+ Draws the same synthetic level frame (a screen-sized map with a backdrop
+ and a terrain layer from two tilesets, then hundreds to thousands of sprites
+ from the game's own textures, some tinted and translucent) through a
+ Renderer and reports how long a frame takes. The map goes through
+ draw_map(), so the multi-layer path is drawn and compared on both backends.
+
+ --headless runs it on the SoftwareRenderer with no window or GPU, with and
+ without SIMD, and checks that the two frames are byte for byte the same;
+ main then draws the first level itself the same way, and that frame is the
+ one written out. --bench-render runs it through GLRenderer in the game's
+ window and diffs the GL frame against the software one. Either can write
+ its frame to a PPM file for image-diff tests.
+ */
+class RenderBenchmark {
+private:
+    struct Textures
+    {
+        GLuint player, monster, fire;
+    };
+
+    static Textures load_textures(Renderer *renderer);
+    static Map *build_map();
+    static void build_frame(const Textures &textures, int sprite_count, std::vector<SpriteBatch::Sprite> &sprites);
+    static void draw_frame(Renderer *renderer, Map *map, const std::vector<SpriteBatch::Sprite> &sprites);
+
+    // Times every scene size; frame gets the smallest scene's image
+    static void run(Renderer *renderer, std::vector<unsigned char> &frame);
+
+    static int count_differences(const std::vector<unsigned char> &a, const std::vector<unsigned char> &b, int *max_difference);
+
+public:
+    // RGBA pixels, first row at the top, as read_pixels() returns them
+    static void write_ppm(const char *filepath, const std::vector<unsigned char> &pixels, int width, int height);
+
+    static void run_headless(int width, int height, const char *image_filepath = NULL);
+    static void run_gl(ShaderProgram *program, int width, int height, const char *image_filepath = NULL);
+};
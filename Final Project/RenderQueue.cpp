@@ -0,0 +1,252 @@
+#include "RenderQueue.h"
+#include "RenderStats.h"
+#include "StaticLayer.h"
+#include <algorithm>
+
+Uint64 RenderQueue::make_key(RenderLayer layer, ShaderProgram *program, GLuint texture_id, float depth)
+{
+    // [63..56] layer  [55..48] program  [47..32] texture  [31..16] depth  [15..0] unused
+    // Depth runs back to front over the -1..1 range of the projection
+    float normalised_depth = std::min(std::max((depth + 1.0f) / 2.0f, 0.0f), 1.0f);
+    Uint64 quantised_depth = (Uint64) (normalised_depth * 65535.0f);
+    
+    return ((Uint64) (layer & 0xff)                 << 56) |
+           ((Uint64) (program->programID & 0xff)    << 48) |
+           ((Uint64) (texture_id & 0xffff)          << 32) |
+           (quantised_depth                         << 16);
+}
+
+void RenderQueue::begin()
+{
+    this->commands.clear();
+    this->text_count = 0;
+    this->sorted = false;
+    this->lights.clear();
+    this->ambient = glm::vec3(1.0f);
+}
+
+void RenderQueue::submit_sprite(RenderLayer layer, ShaderProgram *program, GLuint texture_id, glm::vec3 position, glm::vec3 previous_position, glm::vec3 size, float u, float v, float width, float height, glm::vec4 color, glm::vec4 animation)
+{
+    RenderCommand command = {};
+    command.key = make_key(layer, program, texture_id, position.z);
+    command.type = SPRITE_COMMAND;
+    command.program = program;
+    command.texture_id = texture_id;
+    command.position = position;
+    command.previous_position = previous_position;
+    command.size = size;
+    command.u = u;
+    command.v = v;
+    command.width = width;
+    command.height = height;
+    command.color = color;
+    command.animation = animation;
+    
+    this->commands.push_back(command);
+    this->sorted = false;
+}
+
+void RenderQueue::submit_map(ShaderProgram *program, Map *map, Visibility *visibility)
+{
+    RenderCommand command = {};
+    command.key = make_key(LAYER_MAP, program, map->get_texture_id(), 0.0f);
+    command.type = MAP_COMMAND;
+    command.program = program;
+    command.texture_id = map->get_texture_id();
+    command.map = map;
+    command.has_visibility = visibility != NULL;
+    if (visibility != NULL) command.visibility = *visibility;
+    
+    this->commands.push_back(command);
+    this->sorted = false;
+}
+
+void RenderQueue::submit_static_layer(ShaderProgram *program, StaticLayer *static_layer, Visibility *visibility)
+{
+    RenderCommand command = {};
+    command.key = make_key(LAYER_MAP, program, 0, 0.0f);
+    command.type = STATIC_LAYER_COMMAND;
+    command.program = program;
+    command.static_layer = static_layer;
+    command.has_visibility = visibility != NULL;
+    if (visibility != NULL) command.visibility = *visibility;
+    
+    this->commands.push_back(command);
+    this->sorted = false;
+}
+
+void RenderQueue::submit_text(ShaderProgram *program, GLuint font_texture_id, const std::string &text, float screen_size, float spacing, glm::vec3 position)
+{
+    this->submit_text(program, font_texture_id, text, screen_size, spacing, position, position);
+}
+
+void RenderQueue::submit_text(ShaderProgram *program, GLuint font_texture_id, const std::string &text, float screen_size, float spacing, glm::vec3 position, glm::vec3 previous_position)
+{
+    // Text is copied into a slot that is reused next frame, so callers may pass temporaries
+    if (this->text_count == (int) this->texts.size()) this->texts.emplace_back();
+    this->texts[this->text_count] = text;
+    
+    RenderCommand command = {};
+    command.key = make_key(LAYER_HUD, program, font_texture_id, position.z);
+    command.type = TEXT_COMMAND;
+    command.program = program;
+    command.texture_id = font_texture_id;
+    command.position = position;
+    command.previous_position = previous_position;
+    command.text_index = this->text_count++;
+    command.screen_size = screen_size;
+    command.spacing = spacing;
+    
+    this->commands.push_back(command);
+    this->sorted = false;
+}
+
+void RenderQueue::submit_light(glm::vec3 position, glm::vec3 previous_position, float radius, glm::vec3 color, float intensity)
+{
+    LightCommand command;
+    command.light.position = glm::vec2(position);
+    command.light.radius = radius;
+    command.light.color = color;
+    command.light.intensity = intensity;
+    command.previous_position = glm::vec2(previous_position);
+    
+    this->lights.push_back(command);
+}
+
+void RenderQueue::sort()
+{
+    if (this->sorted) return;
+    this->sorted = true;
+    
+    int count = (int) this->commands.size();
+    this->order.resize(count);
+    this->scratch.resize(count);
+    
+    for (int i = 0; i < count; i++) this->order[i] = { this->commands[i].key, i };
+    
+    // LSD radix sort, one byte per pass. Each pass is stable, so commands with
+    // equal keys keep their submission order
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        int counts[256] = {};
+        for (const SortEntry &entry : this->order) counts[(entry.key >> shift) & 0xff]++;
+        
+        // Every key shares this byte, nothing to do
+        if (counts[(this->order[0].key >> shift) & 0xff] == count) continue;
+        
+        int offset = 0;
+        for (int &bucket : counts)
+        {
+            int bucket_size = bucket;
+            bucket = offset;
+            offset += bucket_size;
+        }
+        
+        for (const SortEntry &entry : this->order) this->scratch[counts[(entry.key >> shift) & 0xff]++] = entry;
+        this->order.swap(this->scratch);
+    }
+}
+
+void RenderQueue::flush(Renderer *renderer, float alpha, Lighting *lighting)
+{
+    if (this->commands.empty()) return;
+    
+    this->sort();
+    
+    // Static layers redraw whatever they cache first, unlit and into their own targets
+    for (const RenderCommand &command : this->commands)
+    {
+        if (command.type == STATIC_LAYER_COMMAND) renderer->update_static_layer(command.static_layer);
+    }
+    
+    // Lights move with everything else
+    if (lighting != NULL)
+    {
+        this->interpolated_lights.clear();
+        for (const LightCommand &command : this->lights)
+        {
+            PointLight light = command.light;
+            light.position = glm::mix(command.previous_position, command.light.position, alpha);
+            this->interpolated_lights.push_back(light);
+        }
+        
+        lighting->begin(this->interpolated_lights, this->ambient);
+    }
+    bool lit = lighting != NULL;
+    
+    int count = (int) this->order.size();
+    for (int i = 0; i < count; i++)
+    {
+        const RenderCommand &command = this->commands[this->order[i].command_index];
+        
+        // The HUD sorts last and is never lit
+        if (lit && (command.key >> 56) >= LAYER_HUD)
+        {
+            lighting->end();
+            lit = false;
+        }
+        
+        switch (command.type)
+        {
+            case SPRITE_COMMAND:
+            {
+                // Gather the whole run of sprites that share a program into one draw
+                this->run_sprites.clear();
+                int run_end = i;
+                while (run_end < count)
+                {
+                    const RenderCommand &sprite = this->commands[this->order[run_end].command_index];
+                    if (sprite.type != SPRITE_COMMAND || sprite.program != command.program) break;
+                    if (lit && (sprite.key >> 56) >= LAYER_HUD) break;
+                    
+                    glm::vec3 position = glm::mix(sprite.previous_position, sprite.position, alpha);
+                    this->run_sprites.push_back({ sprite.texture_id, position, sprite.size, sprite.u, sprite.v, sprite.width, sprite.height, sprite.color, sprite.animation });
+                    run_end++;
+                }
+                renderer->draw_sprites(this->run_sprites.data(), (int) this->run_sprites.size());
+                i = run_end - 1;
+                break;
+            }
+                
+            case MAP_COMMAND:
+            {
+                // The map counts its culled columns into this copy; hand them on before it goes
+                Visibility visibility = command.visibility;
+                visibility.columns_drawn = 0;
+                visibility.columns_culled = 0;
+                renderer->draw_map(command.map, command.has_visibility ? &visibility : NULL);
+                RenderStats::count_columns(visibility.columns_drawn, visibility.columns_culled);
+                break;
+            }
+                
+            case STATIC_LAYER_COMMAND:
+            {
+                renderer->draw_static_layer(command.static_layer, command.has_visibility ? &command.visibility : NULL);
+                break;
+            }
+                
+            case TEXT_COMMAND:
+            {
+                glm::vec3 position = glm::mix(command.previous_position, command.position, alpha);
+                renderer->draw_text(command.texture_id, this->texts[command.text_index], command.screen_size, command.spacing, position);
+                break;
+            }
+        }
+    }
+    
+    if (lit) lighting->end();
+}
+
+void RenderQueue::swap(RenderQueue &other)
+{
+    this->lights.swap(other.lights);
+    std::swap(this->ambient, other.ambient);
+    
+    this->commands.swap(other.commands);
+    this->texts.swap(other.texts);
+    std::swap(this->text_count, other.text_count);
+    
+    // The sort order belongs to the commands it was built from
+    this->order.swap(other.order);
+    std::swap(this->sorted, other.sorted);
+}
@@ -0,0 +1,123 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "ShaderProgram.h"
+#include "SpriteBatch.h"
+#include "Renderer.h"
+#include "Map.h"
+#include "Visibility.h"
+#include "Lighting.h"
+
+// Coarse draw order; everything inside a layer is free to be reordered for state
+enum RenderLayer { LAYER_BACKGROUND, LAYER_MAP, LAYER_ENTITIES, LAYER_HUD };
+enum RenderCommandType { SPRITE_COMMAND, MAP_COMMAND, TEXT_COMMAND, STATIC_LAYER_COMMAND };
+
+class StaticLayer;
+
+/**
+ A scene records what it wants drawn this frame as small commands instead of
+ issuing GL calls in hand-written order. flush() radix-sorts the commands by
+ a 64-bit key of layer | shader | texture | depth and submits them, so each
+ program and texture is bound once per run instead of once per object.
+ Lights are recorded alongside and handed to Lighting for everything below
+ the HUD. Nothing in here calls GL: every command goes to a Renderer, so the
+ same recorded frame can be drawn by GL or on the CPU.
+ */
+class RenderQueue {
+private:
+    struct RenderCommand
+    {
+        Uint64 key;
+        RenderCommandType type;
+        ShaderProgram *program;
+        GLuint texture_id;
+        
+        // SPRITE_COMMAND: centre, size and frame rectangle in UV space
+        // TEXT_COMMAND:   position is the text origin
+        // Both are drawn between previous_position and position by flush()'s alpha
+        glm::vec3 position, previous_position, size;
+        float u, v, width, height;
+        
+        // SPRITE_COMMAND: multiplied into the texel; texture 0 makes a flat quad of this colour
+        glm::vec4 color;
+        
+        // SPRITE_COMMAND: clip parameters for the shader (see Animation); clip 0 is a still frame
+        glm::vec4 animation;
+        
+        // MAP_COMMAND and STATIC_LAYER_COMMAND: the view is copied so the command stays valid on another thread
+        Map *map;
+        StaticLayer *static_layer;
+        Visibility visibility;
+        bool has_visibility;
+        
+        // TEXT_COMMAND: index into texts
+        int text_index;
+        float screen_size, spacing;
+    };
+    
+    struct LightCommand
+    {
+        PointLight light;
+        glm::vec2 previous_position;
+    };
+    
+    struct SortEntry
+    {
+        Uint64 key;
+        int command_index;
+    };
+    
+    // All of these keep their capacity between frames
+    std::vector<RenderCommand> commands;
+    std::vector<std::string> texts;
+    int text_count = 0;
+    std::vector<SortEntry> order, scratch;
+    bool sorted = false;
+    
+    // A run of sprite commands on its way to the renderer
+    std::vector<SpriteBatch::Sprite> run_sprites;
+    
+    std::vector<LightCommand> lights;
+    std::vector<PointLight> interpolated_lights;
+    glm::vec3 ambient = glm::vec3(1.0f);
+    
+    static Uint64 make_key(RenderLayer layer, ShaderProgram *program, GLuint texture_id, float depth);
+    void sort();
+    
+public:
+    void begin();
+    
+    void submit_sprite(RenderLayer layer, ShaderProgram *program, GLuint texture_id, glm::vec3 position, glm::vec3 previous_position, glm::vec3 size, float u, float v, float width, float height,
+                       glm::vec4 color = glm::vec4(1.0f), glm::vec4 animation = glm::vec4(0.0f));
+    void submit_map(ShaderProgram *program, Map *map, Visibility *visibility = NULL);
+    void submit_static_layer(ShaderProgram *program, StaticLayer *static_layer, Visibility *visibility = NULL);
+    void submit_text(ShaderProgram *program, GLuint font_texture_id, const std::string &text, float screen_size, float spacing, glm::vec3 position);
+    void submit_text(ShaderProgram *program, GLuint font_texture_id, const std::string &text, float screen_size, float spacing, glm::vec3 position, glm::vec3 previous_position);
+    void submit_light(glm::vec3 position, glm::vec3 previous_position, float radius, glm::vec3 color, float intensity);
+    
+    // Light everything gets before any point light; white until a scene says otherwise
+    void set_ambient(glm::vec3 color) { this->ambient = color; }
+    
+    // Consecutive sprites with the same program go to the renderer as one
+    // draw_sprites(). Moving things are drawn alpha of the way from their
+    // previous to their current position. A recorded frame can be flushed again
+    // until begin(). The caller begins and ends the renderer's frame. With
+    // lighting (GL only), every layer below LAYER_HUD is lit by the recorded lights
+    void flush(Renderer *renderer, float alpha = 1.0f, Lighting *lighting = NULL);
+    
+    // Trades recorded frames without copying; both sides keep their capacity
+    void swap(RenderQueue &other);
+    
+    int const get_command_count() const { return (int) this->commands.size(); }
+};
@@ -0,0 +1,64 @@
+#include "RenderStats.h"
+#include "GLState.h"
+#include "Utility.h"
+#include <cstdio>
+
+FrameStats RenderStats::current;
+FrameStats RenderStats::last;
+
+int RenderStats::frames_since_refresh = OVERLAY_REFRESH_FRAMES;
+std::string RenderStats::overlay_lines[RenderStats::OVERLAY_LINE_COUNT];
+
+void RenderStats::begin_frame()
+{
+    last = current;
+    current = FrameStats();
+}
+
+void RenderStats::count_draw(int vertex_count, int instance_count)
+{
+    current.draw_calls++;
+    current.vertices += vertex_count * instance_count;
+}
+
+float RenderStats::elapsed_ms(Uint64 start, Uint64 end)
+{
+    return (float) (end - start) * 1000.0f / (float) SDL_GetPerformanceFrequency();
+}
+
+void RenderStats::render_overlay(ShaderProgram *program, SpriteBatch *batch, GLuint font_texture_id)
+{
+    // STEP 1: Rebuild the text now and then from the last complete frame
+    if (++frames_since_refresh >= OVERLAY_REFRESH_FRAMES)
+    {
+        frames_since_refresh = 0;
+        char line[64];
+
+        snprintf(line, sizeof(line), "DRAWS %d BINDS %d PROGRAMS %d", last.draw_calls, last.texture_binds, last.program_switches);
+        overlay_lines[0] = line;
+
+        snprintf(line, sizeof(line), "VERTICES %d GLYPHS %d COLUMNS %d/%d", last.vertices, last.glyphs,
+                 last.columns_drawn, last.columns_drawn + last.columns_culled);
+        overlay_lines[1] = line;
+
+        snprintf(line, sizeof(line), "SCENE %.2f DRAW %.2f SWAP %.2f MS", last.scene_render_ms, last.flush_ms, last.swap_ms);
+        overlay_lines[2] = line;
+
+        snprintf(line, sizeof(line), "SCALE %.2f GPU %.2f CAPTURE %.2f MS", last.resolution_scale, last.gpu_ms, last.capture_ms);
+        overlay_lines[3] = line;
+    }
+
+    // STEP 2: Screen space; the next frame sets its own view matrix again.
+    // The overlay's own draws land in the frame they are drawn in
+    GLState::set_view_matrix(program, glm::mat4(1.0f));
+    
+    // A flat quad through the same program as the text, so no switch between them
+    batch->begin();
+    batch->submit(0, glm::vec3(-1.4f, 2.975f, 0.0f), glm::vec3(7.2f, 1.45f, 1.0f), 0.0f, 0.0f, 1.0f, 1.0f, glm::vec4(0.0f, 0.0f, 0.0f, 0.6f));
+    batch->flush(program);
+
+    for (int i = 0; i < OVERLAY_LINE_COUNT; i++)
+    {
+        Utility::draw_text(program, font_texture_id, overlay_lines[i], 0.3f, 0.2f, glm::vec3(-4.7f, 3.5f - 0.35f * i, 0.0f));
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <string>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "ShaderProgram.h"
+#include "SpriteBatch.h"
+
+/**
+ What one frame cost: GL work counted at the draw sites, and how long the
+ scene took to record, the queue took to draw and the swap took to return.
+ */
+struct FrameStats
+{
+    int draw_calls = 0;
+    int texture_binds = 0;
+    int program_switches = 0;
+    int vertices = 0;
+    int glyphs = 0;
+    
+    // Map columns inside and outside the camera, summed over every map drawn
+    int columns_drawn = 0;
+    int columns_culled = 0;
+
+    float scene_render_ms = 0.0f;
+    float flush_ms = 0.0f;
+    float swap_ms = 0.0f;
+
+    // Dynamic resolution: the scale the scene was drawn at and the GPU time it was picked from
+    float resolution_scale = 1.0f;
+    float gpu_ms = 0.0f;
+
+    // What starting this frame's readback cost while recording
+    float capture_ms = 0.0f;
+};
+
+/**
+ Per-frame render counters, filled in by every draw path on the thread that
+ owns the context. Frames are delimited by begin_frame(); the counts of the
+ last complete frame are what get_last_frame() and the F3 overlay report.
+ */
+class RenderStats {
+private:
+    static FrameStats current;
+    static FrameStats last;
+
+    // The overlay text only changes every OVERLAY_REFRESH_FRAMES frames, so it
+    // stays readable and does not churn the text cache
+    static const int OVERLAY_REFRESH_FRAMES = 30;
+    static int frames_since_refresh;
+    static const int OVERLAY_LINE_COUNT = 4;
+    static std::string overlay_lines[OVERLAY_LINE_COUNT];
+
+public:
+    static void begin_frame();
+
+    static void count_draw(int vertex_count, int instance_count = 1);
+    static void count_texture_bind()            { current.texture_binds++;    }
+    static void count_program_switch()          { current.program_switches++; }
+    static void count_glyphs(int glyph_count)   { current.glyphs += glyph_count; }
+    static void count_columns(int drawn, int culled) { current.columns_drawn += drawn; current.columns_culled += culled; }
+
+    static void set_scene_render_time(float ms) { current.scene_render_ms = ms; }
+    static void set_flush_time(float ms)        { current.flush_ms = ms;        }
+    static void set_swap_time(float ms)         { current.swap_ms = ms;         }
+    static void set_resolution(float scale, float gpu_ms) { current.resolution_scale = scale; current.gpu_ms = gpu_ms; }
+    static void set_capture_time(float ms)      { current.capture_ms = ms;      }
+
+    static const FrameStats &get_last_frame()   { return last; }
+
+    // Milliseconds between two SDL_GetPerformanceCounter() readings
+    static float elapsed_ms(Uint64 start, Uint64 end);
+
+    // Draws the last frame's numbers over a dark panel in the top-left corner of the screen
+    static void render_overlay(ShaderProgram *program, SpriteBatch *batch, GLuint font_texture_id);
+};
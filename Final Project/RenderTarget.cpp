@@ -0,0 +1,56 @@
+#define LEVEL_OF_DETAIL 0    // base image level; Level n is the nth mipmap reduction image
+#define TEXTURE_BORDER 0     // this value MUST be zero
+
+#include "RenderTarget.h"
+#include "Utility.h"
+#include "GLState.h"
+#include <cassert>
+#include <iostream>
+
+RenderTarget::~RenderTarget()
+{
+    GLState::delete_texture(this->texture_id);
+    if (this->framebuffer_id != 0) glDeleteFramebuffers(1, &this->framebuffer_id);
+}
+
+void RenderTarget::resize(int width, int height)
+{
+    if (width == this->width && height == this->height && this->framebuffer_id != 0) return;
+    
+    this->width = width;
+    this->height = height;
+    
+    // STEP 1: The colour texture; nearest keeps pixel art crisp when composited
+    if (this->texture_id == 0) glGenTextures(1, &this->texture_id);
+    GLState::bind_texture(this->texture_id);
+    glTexImage2D(GL_TEXTURE_2D, LEVEL_OF_DETAIL, GL_RGBA, width, height, TEXTURE_BORDER, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    
+    // STEP 2: Attach it to a framebuffer of its own
+    if (this->framebuffer_id == 0) glGenFramebuffers(1, &this->framebuffer_id);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer_id);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->texture_id, LEVEL_OF_DETAIL);
+    
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        LOG("Render target " << width << "x" << height << " is incomplete.");
+        assert(false);
+    }
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RenderTarget::bind()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer_id);
+    glViewport(0, 0, this->width, this->height);
+}
+
+void RenderTarget::unbind()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+
+/**
+ An offscreen colour buffer the scene can be drawn into and then sampled
+ as a texture, e.g. by the Effects composite pass.
+ */
+class RenderTarget {
+private:
+    GLuint framebuffer_id = 0;
+    GLuint texture_id = 0;
+    int width = 0;
+    int height = 0;
+    
+public:
+    ~RenderTarget();
+    
+    // (Re)allocates the colour texture; cheap to call when the size is unchanged
+    void resize(int width, int height);
+    
+    // Redirects drawing here, with a viewport covering the whole target
+    void bind();
+    // Back to the window; the caller restores its own viewport
+    void unbind();
+    
+    GLuint const get_texture_id() const { return this->texture_id; }
+    int    const get_width()      const { return this->width;      }
+    int    const get_height()     const { return this->height;     }
+};
@@ -0,0 +1,146 @@
+#include "RenderThread.h"
+#include "Utility.h"
+
+void RenderThread::start(SDL_Window *window, SDL_GLContext context, std::function<void(FrameSnapshot &)> draw)
+{
+    this->window = window;
+    this->context = context;
+    this->draw = draw;
+    this->stopping = false;
+    this->running = true;
+    
+    // A context can only be current on one thread at a time
+    SDL_GL_MakeCurrent(this->window, NULL);
+    this->thread = std::thread(&RenderThread::loop, this);
+}
+
+void RenderThread::stop()
+{
+    if (!this->running) return;
+    
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->wake.notify_one();
+    this->thread.join();
+    
+    this->running = false;
+    SDL_GL_MakeCurrent(this->window, this->context);
+}
+
+void RenderThread::publish()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        std::swap(this->back, this->ready);
+        this->has_new_snapshot = true;
+    }
+    this->wake.notify_one();
+    
+    // The slot we get back may hold an older frame; start recording from empty
+    this->snapshots[this->back].queue.begin();
+}
+
+void RenderThread::run(std::function<void()> job)
+{
+    if (!this->running)
+    {
+        job();
+        return;
+    }
+    
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->jobs.push_back(job);
+    int ticket = this->jobs_finished + (int) this->jobs.size();
+    this->wake.notify_one();
+    this->job_done.wait(lock, [&]() { return this->jobs_finished >= ticket; });
+}
+
+void RenderThread::loop()
+{
+    SDL_GL_MakeCurrent(this->window, this->context);
+    
+    // Without vsync a redraw loop would spin, so only draw what is new. Whether
+    // the swaps really wait is only known once a few have been timed
+    this->redraw_every_refresh = SDL_GL_SetSwapInterval(1) == 0;
+    this->vsync_checked = !this->redraw_every_refresh;
+    this->vsync_frames = 0;
+    
+    std::vector<std::function<void()>> pending_jobs;
+    
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->wake.wait(lock, [&]() {
+                return this->stopping || this->has_new_snapshot || !this->jobs.empty() ||
+                       (this->has_frame && this->redraw_every_refresh);
+            });
+            
+            if (this->stopping) break;
+            
+            if (!this->jobs.empty())
+            {
+                pending_jobs.swap(this->jobs);
+            }
+            else if (this->has_new_snapshot)
+            {
+                std::swap(this->front, this->ready);
+                this->has_new_snapshot = false;
+                this->has_frame = true;
+            }
+        }
+        
+        if (!pending_jobs.empty())
+        {
+            for (std::function<void()> &job : pending_jobs) job();
+            
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->jobs_finished += (int) pending_jobs.size();
+                
+                // Whatever was published before the job may point at state it just replaced
+                this->has_new_snapshot = false;
+                this->has_frame = false;
+            }
+            pending_jobs.clear();
+            
+            // The wait for the next snapshot isn't a swap; time afresh
+            this->vsync_frames = 0;
+            this->job_done.notify_all();
+            continue;
+        }
+        
+        this->draw(this->snapshots[this->front]);
+        if (!this->vsync_checked) this->check_vsync();
+    }
+    
+    SDL_GL_MakeCurrent(this->window, NULL);
+}
+
+void RenderThread::check_vsync()
+{
+    // STEP 1: Redraws run back to back, so once the swap chain has filled up,
+    // the time between them is how long a swap really waits
+    Uint64 now = SDL_GetPerformanceCounter();
+    this->vsync_frames++;
+    
+    if (this->vsync_frames == VSYNC_WARMUP_FRAMES) this->vsync_start = now;
+    if (this->vsync_frames < VSYNC_WARMUP_FRAMES + VSYNC_MEASURED_FRAMES) return;
+    
+    this->vsync_checked = true;
+    float frame_ms = (float) (now - this->vsync_start) * 1000.0f / (float) SDL_GetPerformanceFrequency() / VSYNC_MEASURED_FRAMES;
+    
+    // STEP 2: Against the display's own refresh, or 60 Hz if it won't say
+    SDL_DisplayMode mode;
+    int refresh_rate = (SDL_GetWindowDisplayMode(this->window, &mode) == 0 && mode.refresh_rate > 0) ? mode.refresh_rate : 60;
+    
+    // Well under half a refresh per swap means nothing is throttling them
+    if (frame_ms < 500.0f / refresh_rate)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->redraw_every_refresh = false;
+        LOG("Swaps took " << frame_ms << " ms against a " << refresh_rate << " Hz display; vsync is off, so only new frames are drawn.");
+    }
+}
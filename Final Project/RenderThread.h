@@ -0,0 +1,109 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "RenderQueue.h"
+#include "SpriteBatch.h"
+#include "Effects.h"
+
+/**
+ Everything the GL side needs to draw one simulated frame. Commands hold
+ positions, frames and text by value, so the simulation is free to move on
+ as soon as a snapshot is published.
+ */
+struct FrameSnapshot
+{
+    RenderQueue queue;
+    glm::mat4 view_matrix = glm::mat4(1.0f);
+    glm::mat4 previous_view_matrix = glm::mat4(1.0f);
+    SpriteBatch *batch = NULL;
+    PostProcess post_process;
+    
+    // Interpolation: fraction of a step already elapsed when recorded, and when that was
+    float alpha = 1.0f;
+    Uint64 recorded_at = 0;
+    
+    // Render stats: how long Scene::render took to record this, and whether to show the overlay
+    float scene_render_ms = 0.0f;
+    bool show_stats = false;
+    
+    // F9: whether frames are being recorded to disk
+    bool capture = false;
+};
+
+/**
+ Owns the GL context on a second thread. The simulation records into the
+ back snapshot and publishes it; the render thread always draws the newest
+ published one. Three slots mean neither side ever waits on the other: a
+ frame the renderer was too slow to pick up is simply replaced, and with
+ vsync the renderer redraws the newest one at display rate.
+
+ Anything else that needs GL (loading a scene, say) is handed over with
+ run(), which blocks until the render thread has done it.
+ */
+class RenderThread {
+private:
+    SDL_Window *window = NULL;
+    SDL_GLContext context = NULL;
+    std::function<void(FrameSnapshot &)> draw;
+    
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool running = false;
+    bool stopping = false;
+    
+    // back: being recorded, ready: newest published, front: being drawn
+    FrameSnapshot snapshots[3];
+    int back = 0, ready = 1, front = 2;
+    bool has_new_snapshot = false;
+    
+    // With vsync the newest snapshot is redrawn every refresh, interpolating further each time
+    bool has_frame = false;
+    bool redraw_every_refresh = false;
+    
+    // A successful SDL_GL_SetSwapInterval(1) doesn't mean swaps wait: some drivers and
+    // compositors force vsync off. The first redraws are timed against the display's
+    // refresh, and if they come back much faster, redrawing is switched off
+    static const int VSYNC_WARMUP_FRAMES = 5;
+    static const int VSYNC_MEASURED_FRAMES = 30;
+    bool vsync_checked = false;
+    int vsync_frames = 0;
+    Uint64 vsync_start = 0;
+    
+    void check_vsync();
+    
+    std::vector<std::function<void()>> jobs;
+    int jobs_finished = 0;
+    std::condition_variable job_done;
+    
+    void loop();
+    
+public:
+    ~RenderThread() { this->stop(); }
+    
+    // The context is released on the calling thread and made current on the new one
+    void start(SDL_Window *window, SDL_GLContext context, std::function<void(FrameSnapshot &)> draw);
+    // Joins the thread and makes the context current on the caller again
+    void stop();
+    
+    FrameSnapshot &get_back_snapshot() { return this->snapshots[this->back]; }
+    void publish();
+    
+    // Runs the job on the GL thread and waits for it; inline when not started
+    void run(std::function<void()> job);
+    
+    bool const is_running() const { return this->running; }
+};
@@ -0,0 +1,22 @@
+#include "Renderer.h"
+#include "Map.h"
+#include "StaticLayer.h"
+#include "Utility.h"
+
+void Renderer::draw_map(Map *map, Visibility *visibility)
+{
+    map->get_sprites(visibility, this->expanded);
+    if (!this->expanded.empty()) this->draw_sprites(this->expanded.data(), (int) this->expanded.size());
+}
+
+void Renderer::draw_text(GLuint font_texture_id, const std::string &text, float screen_size, float spacing, glm::vec3 position)
+{
+    Utility::get_text_sprites(font_texture_id, text, screen_size, spacing, position, this->expanded);
+    if (!this->expanded.empty()) this->draw_sprites(this->expanded.data(), (int) this->expanded.size());
+}
+
+void Renderer::draw_static_layer(StaticLayer *static_layer, const Visibility *visibility)
+{
+    // Nothing cached: the content goes straight through, and whatever is off screen is clipped
+    static_layer->draw(this);
+}
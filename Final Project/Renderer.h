@@ -0,0 +1,67 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "SpriteBatch.h"
+#include "Visibility.h"
+
+class Map;
+class StaticLayer;
+
+/**
+ The part of drawing a frame that doesn't care what draws it: textures in,
+ textured and alpha-blended 2D quads (SpriteBatch::Sprite records) out, and
+ the finished frame read back as pixels. GLRenderer is the game's own GL
+ path; SoftwareRenderer does the same on the CPU, so frames can be drawn,
+ timed and compared on a machine with no GPU.
+
+ RenderQueue::flush() draws a scene's maps, text and static layers through
+ here too. By default each comes down to sprites (a tile or a glyph each, and
+ a static layer's content as recorded); GLRenderer keeps the game's faster
+ paths for them: chunk buffers, cached text meshes and prerendered strips.
+ */
+class Renderer {
+protected:
+    // What the default map and text paths expand into; keeps its capacity
+    std::vector<SpriteBatch::Sprite> expanded;
+
+public:
+    virtual ~Renderer() {}
+
+    // RGBA, 4 bytes a texel, first row at the top (the way stb_image loads them)
+    virtual GLuint create_texture(int width, int height, const unsigned char *pixels) = 0;
+    virtual void delete_texture(GLuint texture_id) = 0;
+
+    // Clears to clear_color. Each draw_sprites() call may regroup its quads by
+    // texture, as SpriteBatch does, but keeps their order within a texture
+    virtual void begin_frame(const glm::mat4 &view_matrix, const glm::mat4 &projection_matrix, glm::vec4 clear_color) = 0;
+    virtual void draw_sprites(const SpriteBatch::Sprite *sprites, int count) = 0;
+
+    // The tiles visibility overlaps (all of them without one), counting columns into it
+    virtual void draw_map(Map *map, Visibility *visibility);
+    virtual void draw_text(GLuint font_texture_id, const std::string &text, float screen_size, float spacing, glm::vec3 position);
+
+    // update_static_layer() runs for every static layer before anything else
+    // in the frame is drawn, so a backend that caches the layer can redraw it
+    virtual void update_static_layer(StaticLayer *static_layer) {}
+    virtual void draw_static_layer(StaticLayer *static_layer, const Visibility *visibility);
+
+    // Returns once the frame is really drawn, so it can be timed
+    virtual void end_frame() = 0;
+
+    // RGBA, first row at the top
+    virtual void read_pixels(std::vector<unsigned char> &pixels) = 0;
+
+    virtual int get_width() const = 0;
+    virtual int get_height() const = 0;
+    virtual const char *get_name() const = 0;
+};
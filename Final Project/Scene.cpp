@@ -6,3 +6,14 @@
 //
 
 #include "Scene.h"
+
+const std::string &Scene::get_lives_label()
+{
+    if (this->lives_label_value != this->num_of_lives)
+    {
+        this->lives_label = "lives: " + std::to_string(this->num_of_lives);
+        this->lives_label_value = this->num_of_lives;
+    }
+    
+    return this->lives_label;
+}
@@ -15,6 +15,10 @@
 #include "Util.h"
 #include "Entity.h"
 #include "Map.h"
+#include "SpriteBatch.h"
+#include "RenderQueue.h"
+#include "StaticLayer.h"
+#include "Visibility.h"
 
 struct GameState
 {
@@ -26,6 +30,7 @@ struct GameState
     Entity *weapon;
     Entity *background;
     Entity *item;
+    TextureAtlas *atlas = NULL;
     
     Mix_Music *bgm;
     Mix_Chunk *jump_sfx;
@@ -43,11 +48,24 @@ public:
     int number_of_enemies = 1;
     int num_of_lives = 3;
     
+    // "lives: N", rebuilt only when num_of_lives changes
+    std::string lives_label;
+    int lives_label_value = -1;
+    
     GameState state;
+    SpriteBatch sprite_batch;
+    RenderQueue render_queue;
+    Visibility visibility;
+    
+    // The map and anything else that never moves, drawn once and reused every frame
+    StaticLayer static_layer;
     
     virtual void initialise() = 0;
     virtual void update(float delta_time) = 0;
+    // Records this frame's draws into render_queue; the caller flushes it
     virtual void render(ShaderProgram *program) = 0;
     
+    const std::string &get_lives_label();
+    
     GameState const get_state() const { return this->state; }
 };
@@ -0,0 +1,217 @@
+#include "ShaderCache.h"
+#include "Utility.h"
+#include "GLState.h"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+std::map<Uint64, ShaderProgram> ShaderCache::programs;
+std::string ShaderCache::directory;
+const char *ShaderCache::ATTRIBUTE_LAYOUT = "position=0";
+
+static bool program_binaries_supported()
+{
+#ifdef GL_NUM_PROGRAM_BINARY_FORMATS
+    static int format_count = -1;
+    if (format_count < 0)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+        glGetError(); // contexts that predate the enum flag it as invalid
+        format_count = count;
+    }
+
+#ifdef _WINDOWS
+    if (glProgramBinary == NULL || glGetProgramBinary == NULL) return false;
+#endif
+
+    return format_count > 0;
+#else
+    return false;
+#endif
+}
+
+Uint64 ShaderCache::hash(const char *vertex_source, const char *fragment_source)
+{
+    // FNV-1a over both sources, the attribute layout and the driver strings; a
+    // driver update produces new keys rather than feeding it a binary it may reject
+    const char *parts[] =
+    {
+        vertex_source,
+        fragment_source,
+        ATTRIBUTE_LAYOUT,
+        (const char *) glGetString(GL_VENDOR),
+        (const char *) glGetString(GL_RENDERER),
+        (const char *) glGetString(GL_VERSION)
+    };
+
+    Uint64 value = 14695981039346656037ull;
+    for (const char *part : parts)
+    {
+        if (part == NULL) continue;
+        for (const char *c = part; *c != '\0'; c++)
+        {
+            value ^= (unsigned char) *c;
+            value *= 1099511628211ull;
+        }
+
+        // Separator, so moving text from one part to the next changes the key
+        value ^= 0xff;
+        value *= 1099511628211ull;
+    }
+
+    return value;
+}
+
+std::string ShaderCache::get_binary_path(Uint64 key)
+{
+    if (directory.empty())
+    {
+        char *pref_path = SDL_GetPrefPath("Lavaboy", "ShaderCache");
+        directory = (pref_path != NULL) ? pref_path : "./";
+        if (pref_path != NULL) SDL_free(pref_path);
+    }
+
+    std::ostringstream path;
+    path << directory << "program_" << std::hex << key << ".bin";
+    return path.str();
+}
+
+bool ShaderCache::load_binary(ShaderProgram &program, Uint64 key)
+{
+#ifdef GL_NUM_PROGRAM_BINARY_FORMATS
+    if (!program_binaries_supported()) return false;
+
+    std::string path = get_binary_path(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    GLenum format = 0;
+    file.read((char *) &format, sizeof(format));
+    std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (binary.empty()) return false;
+
+    program.programID = glCreateProgram();
+    glProgramBinary(program.programID, format, binary.data(), (GLsizei) binary.size());
+
+    // Drivers may refuse a binary at any time; drop it and compile instead
+    GLint link_success;
+    glGetProgramiv(program.programID, GL_LINK_STATUS, &link_success);
+    if (link_success == GL_FALSE)
+    {
+        glDeleteProgram(program.programID);
+        program.programID = 0;
+        std::remove(path.c_str());
+        return false;
+    }
+
+    program.vertexShader = 0;
+    program.fragmentShader = 0;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ShaderCache::save_binary(const ShaderProgram &program, Uint64 key)
+{
+#ifdef GL_NUM_PROGRAM_BINARY_FORMATS
+    if (!program_binaries_supported()) return;
+
+    GLint length = 0;
+    glGetProgramiv(program.programID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program.programID, length, &length, &format, binary.data());
+
+    // Write beside the real file and rename, so a crash never leaves half a binary
+    std::string path = get_binary_path(key);
+    std::string temporary_path = path + ".tmp";
+    {
+        std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+        if (!file) return;
+
+        file.write((const char *) &format, sizeof(format));
+        file.write(binary.data(), length);
+        if (!file) return;
+    }
+
+    std::remove(path.c_str());
+    std::rename(temporary_path.c_str(), path.c_str());
+#endif
+}
+
+void ShaderCache::compile(ShaderProgram &program, const char *vertex_source, const char *fragment_source)
+{
+    program.vertexShader = program.LoadShaderFromString(vertex_source, GL_VERTEX_SHADER);
+    program.fragmentShader = program.LoadShaderFromString(fragment_source, GL_FRAGMENT_SHADER);
+
+    program.programID = glCreateProgram();
+    glAttachShader(program.programID, program.vertexShader);
+    glAttachShader(program.programID, program.fragmentShader);
+
+#ifdef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+    if (program_binaries_supported()) glProgramParameteri(program.programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+
+    // Legacy contexts only draw while attribute 0 is enabled, and position is
+    // enabled for every draw; left to the linker, 0 could go to any attribute
+    glBindAttribLocation(program.programID, 0, "position");
+    glLinkProgram(program.programID);
+
+    GLint link_success;
+    glGetProgramiv(program.programID, GL_LINK_STATUS, &link_success);
+    if (link_success == GL_FALSE)
+    {
+        LOG("Error linking shader program!");
+        assert(false);
+    }
+}
+
+void ShaderCache::find_locations(ShaderProgram &program)
+{
+    program.modelMatrixUniform      = glGetUniformLocation(program.programID, "modelMatrix");
+    program.projectionMatrixUniform = glGetUniformLocation(program.programID, "projectionMatrix");
+    program.viewMatrixUniform       = glGetUniformLocation(program.programID, "viewMatrix");
+    program.colorUniform            = glGetUniformLocation(program.programID, "color");
+
+    program.positionAttribute = glGetAttribLocation(program.programID, "position");
+    program.texCoordAttribute = glGetAttribLocation(program.programID, "texCoord");
+
+    // Same default ShaderProgram::Load sets, but through the tracker
+    GLState::set_color(&program, 1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+void ShaderCache::load(ShaderProgram &program, const char *vertex_source, const char *fragment_source)
+{
+    Uint64 key = hash(vertex_source, fragment_source);
+
+    // STEP 1: Already linked this run
+    auto cached = programs.find(key);
+    if (cached != programs.end())
+    {
+        program = cached->second;
+        return;
+    }
+
+    // STEP 2: Linked on an earlier run, or STEP 3: compile and keep the result
+    if (!load_binary(program, key))
+    {
+        compile(program, vertex_source, fragment_source);
+        save_binary(program, key);
+    }
+
+    find_locations(program);
+    programs[key] = program;
+}
+
+void ShaderCache::clear()
+{
+    for (auto &entry : programs) entry.second.Cleanup();
+    programs.clear();
+}
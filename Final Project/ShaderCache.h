@@ -0,0 +1,46 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <map>
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "ShaderProgram.h"
+
+/**
+ Builds ShaderPrograms from embedded sources (see ShaderSources.h) instead of
+ ShaderProgram::Load's file reads, and skips compiling where it can:
+ programs already linked this run are shared, and linked program binaries
+ are kept on disk via glGetProgramBinary, keyed by a hash of the sources and
+ the driver, so later launches only call glProgramBinary. Drivers without
+ program binaries (e.g. macOS legacy contexts) just compile from source.
+ */
+class ShaderCache {
+private:
+    static std::map<Uint64, ShaderProgram> programs;
+    static std::string directory;
+
+    // Attribute locations fixed before linking. Part of every key, so binaries
+    // linked with another layout are never loaded; change it with the binding
+    static const char *ATTRIBUTE_LAYOUT;
+
+    static Uint64 hash(const char *vertex_source, const char *fragment_source);
+    static std::string get_binary_path(Uint64 key);
+
+    static bool load_binary(ShaderProgram &program, Uint64 key);
+    static void save_binary(const ShaderProgram &program, Uint64 key);
+    static void compile(ShaderProgram &program, const char *vertex_source, const char *fragment_source);
+    static void find_locations(ShaderProgram &program);
+
+public:
+    static void load(ShaderProgram &program, const char *vertex_source, const char *fragment_source);
+
+    // Deletes every program handed out; call before the GL context goes away
+    static void clear();
+};
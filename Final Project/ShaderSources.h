@@ -0,0 +1,170 @@
+#pragma once
+
+/**
+ Every shader the game uses, compiled into the executable so startup never
+ touches the disk for GLSL. Edit the sources here; ShaderCache hashes them,
+ so a changed shader invalidates its cached program binary automatically.
+ */
+
+// Uber-shader: maps, text, sprites and flat-colour quads all draw with this one
+// program. Attributes a draw does not supply fall back to their generic
+// defaults (see GLState::set_attribute_default), which reduce it to a plain
+// textured quad: white, textured, an identity instance transform and no
+// animation. The animation table sizes mirror Animation::MAX_FRAMES and
+// Animation::MAX_CLIPS
+const char VERTEX_UBER_SHADER_SOURCE[] = R"GLSL(
+#define MAX_ANIMATION_FRAMES 64
+#define MAX_ANIMATION_CLIPS 16
+
+attribute vec4 position;
+attribute vec2 texCoord;
+
+// Default (1, 1, 1, 1): multiplied into the texel, or the whole colour when untextured
+attribute vec4 vertexColor;
+// Default 1; 0 ignores the texture
+attribute float vertexTextured;
+
+// Instanced sprites only. Default (0, 0, 1, 1) for both
+// xy = centre, zw = size
+attribute vec4 instanceTransform;
+// xy = frame origin, zw = frame size (UV space)
+attribute vec4 instanceUV;
+
+// Default (0, 0, 0, 0). x = clip id (0 for a still frame), y = frames per
+// second, z = start time, w = frame it started on. An animated draw gives its
+// quad UVs over (0, 0)-(1, 1) and the clip's frame places them in the texture
+attribute vec4 animation;
+
+uniform mat4 modelMatrix;
+uniform mat4 viewMatrix;
+uniform mat4 projectionMatrix;
+
+uniform float time;
+uniform vec4 animationFrames[MAX_ANIMATION_FRAMES]; // (u, v, width, height)
+uniform vec4 animationClips[MAX_ANIMATION_CLIPS];   // (first frame, frame count, -, -) of clip 1 on
+
+varying vec2 texCoordVar;
+varying vec4 colorVar;
+varying float texturedVar;
+varying vec2 worldPosition;
+
+void main()
+{
+    vec4 p = modelMatrix * vec4(instanceTransform.xy + position.xy * instanceTransform.zw, 0.0, 1.0);
+    texCoordVar = instanceUV.xy + texCoord * instanceUV.zw;
+    
+    if (animation.x > 0.5)
+    {
+        vec4 clip = animationClips[int(animation.x + 0.5) - 1];
+        float frame = mod(animation.w + floor((time - animation.z) * animation.y), clip.y);
+        vec4 rectangle = animationFrames[int(clip.x + frame + 0.5)];
+        texCoordVar = rectangle.xy + texCoordVar * rectangle.zw;
+    }
+    colorVar = vertexColor;
+    texturedVar = vertexTextured;
+    worldPosition = p.xy;
+    gl_Position = projectionMatrix * viewMatrix * p;
+}
+)GLSL";
+
+// Lighting: see Lighting.h for the table layouts. The constants below mirror
+// MAX_LIGHTS, MAX_LIGHTS_PER_TILE, TILE_COLUMNS, TILE_ROWS and SLOTS_PER_TILE
+const char FRAGMENT_UBER_SHADER_SOURCE[] = R"GLSL(
+#define MAX_LIGHTS 256.0
+#define MAX_LIGHTS_PER_TILE 16
+#define TILE_COLUMNS 16.0
+#define TILE_ROWS 12.0
+#define SLOTS_PER_TILE 5.0
+
+uniform sampler2D diffuse;
+
+uniform float lightingEnabled;  // 0 for HUD and overlays
+uniform vec3 ambient;
+uniform sampler2D lightData;    // MAX_LIGHTS x 2: (x, y, radius, intensity), (r, g, b, -)
+uniform sampler2D lightTiles;   // per tile: (count), then four light indices per texel
+uniform vec2 lightGridOrigin;   // world position of the grid's bottom-left corner
+uniform vec2 lightGridScale;    // tiles per world unit
+
+varying vec2 texCoordVar;
+varying vec4 colorVar;
+varying float texturedVar;
+varying vec2 worldPosition;
+
+vec3 light_at(vec2 p)
+{
+    vec2 tile = floor((p - lightGridOrigin) * lightGridScale);
+    if (tile.x < 0.0 || tile.y < 0.0 || tile.x >= TILE_COLUMNS || tile.y >= TILE_ROWS) return ambient;
+    
+    float row = (tile.y + 0.5) / TILE_ROWS;
+    float first_texel = tile.x * SLOTS_PER_TILE;
+    float count = texture2D(lightTiles, vec2((first_texel + 0.5) / (TILE_COLUMNS * SLOTS_PER_TILE), row)).r;
+    
+    // Only this tile's lights, however many the scene has
+    vec3 light = ambient;
+    for (int i = 0; i < MAX_LIGHTS_PER_TILE; i++)
+    {
+        if (float(i) >= count) break;
+        
+        float slot = first_texel + 1.0 + floor(float(i) / 4.0);
+        vec4 indices = texture2D(lightTiles, vec2((slot + 0.5) / (TILE_COLUMNS * SLOTS_PER_TILE), row));
+        float index = indices[int(mod(float(i), 4.0))];
+        
+        vec4 data = texture2D(lightData, vec2((index + 0.5) / MAX_LIGHTS, 0.25));
+        vec3 color = texture2D(lightData, vec2((index + 0.5) / MAX_LIGHTS, 0.75)).rgb;
+        
+        float falloff = clamp(1.0 - length(p - data.xy) / data.z, 0.0, 1.0);
+        light += color * data.w * falloff * falloff;
+    }
+    
+    return light;
+}
+
+void main()
+{
+    vec4 texel = texture2D(diffuse, texCoordVar);
+    vec4 colour = mix(vec4(1.0), texel, texturedVar) * colorVar;
+    
+    if (lightingEnabled > 0.5) colour.rgb *= light_at(worldPosition);
+    gl_FragColor = colour;
+}
+)GLSL";
+
+// Effects: full-screen composite of the offscreen scene with every active effect
+const char VERTEX_COMPOSITE_SHADER_SOURCE[] = R"GLSL(
+attribute vec4 position;
+attribute vec2 texCoord;
+
+varying vec2 texCoordVar;
+
+void main()
+{
+    texCoordVar = texCoord;
+    gl_Position = position;
+}
+)GLSL";
+
+const char FRAGMENT_COMPOSITE_SHADER_SOURCE[] = R"GLSL(
+uniform sampler2D diffuse;
+
+uniform float fade;        // 0 = scene, 1 = black
+uniform float cover;       // black iris radius, 1 reaches the corners
+uniform float aspect;      // width / height
+uniform vec2 shakeOffset;  // UV space
+uniform vec3 tint;
+uniform vec2 uvScale;      // the part of the target the scene was drawn into
+uniform vec2 uvMax;        // last texel centre inside that part
+
+varying vec2 texCoordVar;
+
+void main()
+{
+    vec2 source = clamp((texCoordVar + shakeOffset) * uvScale, vec2(0.0), uvMax);
+    vec3 colour = texture2D(diffuse, source).rgb * tint;
+    
+    vec2 from_centre = (texCoordVar - 0.5) * vec2(aspect, 1.0);
+    float corner = length(vec2(0.5 * aspect, 0.5));
+    if (length(from_centre) < cover * corner) colour = vec3(0.0);
+    
+    gl_FragColor = vec4(mix(colour, vec3(0.0), fade), 1.0);
+}
+)GLSL";
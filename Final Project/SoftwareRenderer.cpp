@@ -0,0 +1,199 @@
+#include "SoftwareRenderer.h"
+#include "Animation.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFTWARE_RENDERER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+bool SoftwareRenderer::simd_enabled = true;
+
+SoftwareRenderer::SoftwareRenderer(int width, int height)
+{
+    this->width = width;
+    this->height = height;
+    this->pixels.assign(width * height, 0);
+
+    this->white.width = 1;
+    this->white.height = 1;
+    this->white.texels.assign(1, 0xFFFFFFFF);
+}
+
+GLuint SoftwareRenderer::create_texture(int width, int height, const unsigned char *pixels)
+{
+    Texture texture;
+    texture.width = width;
+    texture.height = height;
+    texture.texels.resize(width * height);
+    memcpy(texture.texels.data(), pixels, width * height * 4);
+
+    GLuint texture_id = this->next_texture_id++;
+    this->textures[texture_id] = texture;
+    return texture_id;
+}
+
+void SoftwareRenderer::delete_texture(GLuint texture_id)
+{
+    this->textures.erase(texture_id);
+}
+
+void SoftwareRenderer::begin_frame(const glm::mat4 &view_matrix, const glm::mat4 &projection_matrix, glm::vec4 clear_color)
+{
+    this->view_projection = projection_matrix * view_matrix;
+    this->frame_time = this->time >= 0.0f ? this->time : Animation::now();
+
+    unsigned char clear[4];
+    for (int i = 0; i < 4; i++) clear[i] = (unsigned char) (std::min(std::max(clear_color[i], 0.0f), 1.0f) * 255.0f + 0.5f);
+
+    uint32_t clear_pixel;
+    memcpy(&clear_pixel, clear, 4);
+    std::fill(this->pixels.begin(), this->pixels.end(), clear_pixel);
+}
+
+void SoftwareRenderer::draw_sprites(const SpriteBatch::Sprite *sprites, int count)
+{
+    // The same regrouping SpriteBatch::flush does, so both backends stack quads alike
+    this->sorted.assign(sprites, sprites + count);
+    std::stable_sort(this->sorted.begin(), this->sorted.end(),
+                     [](const SpriteBatch::Sprite &a, const SpriteBatch::Sprite &b) { return a.texture_id < b.texture_id; });
+
+    for (const SpriteBatch::Sprite &sprite : this->sorted) this->draw_sprite(sprite);
+}
+
+void SoftwareRenderer::draw_sprite(const SpriteBatch::Sprite &sprite)
+{
+    const Texture *texture = &this->white;
+    if (sprite.texture_id != 0)
+    {
+        auto found = this->textures.find(sprite.texture_id);
+        if (found == this->textures.end()) return;
+        texture = &found->second;
+    }
+
+    // STEP 1: The frame rectangle, moved onto the clip's current frame if it has one
+    glm::vec4 uv(sprite.u, sprite.v, sprite.width, sprite.height);
+    glm::vec4 frame;
+    if (Animation::frame_rectangle(sprite.animation, this->frame_time, &frame))
+    {
+        uv = glm::vec4(frame.x + uv.x * frame.z, frame.y + uv.y * frame.w, uv.z * frame.z, uv.w * frame.w);
+    }
+
+    // STEP 2: Bottom-left and top-right corners to pixels, row 0 at the top
+    glm::vec4 corner_a = this->view_projection * glm::vec4(sprite.position.x - sprite.size.x / 2.0f, sprite.position.y - sprite.size.y / 2.0f, 0.0f, 1.0f);
+    glm::vec4 corner_b = this->view_projection * glm::vec4(sprite.position.x + sprite.size.x / 2.0f, sprite.position.y + sprite.size.y / 2.0f, 0.0f, 1.0f);
+
+    float x_a = (corner_a.x / corner_a.w + 1.0f) * 0.5f * this->width;
+    float y_a = (1.0f - corner_a.y / corner_a.w) * 0.5f * this->height;
+    float x_b = (corner_b.x / corner_b.w + 1.0f) * 0.5f * this->width;
+    float y_b = (1.0f - corner_b.y / corner_b.w) * 0.5f * this->height;
+    if (x_a == x_b || y_a == y_b) return;
+
+    // Texel coordinates at each corner, and how far they move per pixel
+    float u_a = uv.x * texture->width,                 u_b = (uv.x + uv.z) * texture->width;
+    float v_a = (uv.y + uv.w) * texture->height,       v_b = uv.y * texture->height;
+    float du = (u_b - u_a) / (x_b - x_a);
+    float dv = (v_b - v_a) / (y_b - y_a);
+
+    // STEP 3: Pixels whose centres are inside, clipped to the buffer
+    int first_x = std::max((int) ceil(std::min(x_a, x_b) - 0.5f), 0);
+    int last_x  = std::min((int) ceil(std::max(x_a, x_b) - 0.5f), this->width);
+    int first_y = std::max((int) ceil(std::min(y_a, y_b) - 0.5f), 0);
+    int last_y  = std::min((int) ceil(std::max(y_a, y_b) - 0.5f), this->height);
+    if (first_x >= last_x || first_y >= last_y) return;
+
+    uint16_t color[4];
+    for (int i = 0; i < 4; i++) color[i] = (uint16_t) (std::min(std::max(sprite.color[i], 0.0f), 1.0f) * 255.0f + 0.5f);
+
+    float u = u_a + (first_x + 0.5f - x_a) * du;
+
+    // STEP 4: One span per row
+    for (int y = first_y; y < last_y; y++)
+    {
+        float v = v_a + (y + 0.5f - y_a) * dv;
+        int texel_y = std::min(std::max((int) floor(v), 0), texture->height - 1);
+
+        fill_span(&this->pixels[y * this->width + first_x], last_x - first_x,
+                  &texture->texels[texel_y * texture->width], texture->width, u, du, color);
+    }
+}
+
+void SoftwareRenderer::fill_span_scalar(uint32_t *target, int count, const uint32_t *texel_row, int texel_count, float u, float du, const uint16_t color[4], int first)
+{
+    for (int i = first; i < count; i++)
+    {
+        // Clamped, then truncated: the same texel the SIMD path picks
+        float texel_u = std::min(std::max(u + du * (float) i, 0.0f), (float) (texel_count - 1));
+        const unsigned char *texel = (const unsigned char *) &texel_row[(int) texel_u];
+        unsigned char *pixel = (unsigned char *) &target[i];
+
+        // Texel times colour, then source-over; (x + 255) >> 8 stands in for / 255
+        uint16_t source[4];
+        for (int c = 0; c < 4; c++) source[c] = (uint16_t) ((texel[c] * color[c] + 255) >> 8);
+
+        uint16_t alpha = source[3];
+        for (int c = 0; c < 4; c++) pixel[c] = (unsigned char) ((source[c] * alpha + pixel[c] * (255 - alpha) + 255) >> 8);
+    }
+}
+
+void SoftwareRenderer::fill_span(uint32_t *target, int count, const uint32_t *texel_row, int texel_count, float u, float du, const uint16_t color[4])
+{
+    int i = 0;
+
+#ifdef SOFTWARE_RENDERER_SSE2
+    if (simd_enabled)
+    {
+        const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+        const __m128 first_u = _mm_set1_ps(u);
+        const __m128 step_u = _mm_set1_ps(du);
+        const __m128 last_texel = _mm_set1_ps((float) (texel_count - 1));
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i full = _mm_set1_epi16(255);
+        const __m128i tint = _mm_setr_epi16(color[0], color[1], color[2], color[3], color[0], color[1], color[2], color[3]);
+
+        for (; i + 4 <= count; i += 4)
+        {
+            // STEP 1: Four texel columns at once, then fetch the texels
+            __m128 texel_u = _mm_add_ps(first_u, _mm_mul_ps(step_u, _mm_add_ps(_mm_set1_ps((float) i), lanes)));
+            texel_u = _mm_min_ps(_mm_max_ps(texel_u, _mm_setzero_ps()), last_texel);
+
+            int columns[4];
+            _mm_storeu_si128((__m128i *) columns, _mm_cvttps_epi32(texel_u));
+            __m128i source = _mm_setr_epi32((int) texel_row[columns[0]], (int) texel_row[columns[1]],
+                                            (int) texel_row[columns[2]], (int) texel_row[columns[3]]);
+            __m128i destination = _mm_loadu_si128((const __m128i *) (target + i));
+
+            // STEP 2: Two pixels per register, a 16-bit lane per channel
+            __m128i source_low  = _mm_unpacklo_epi8(source, zero);
+            __m128i source_high = _mm_unpackhi_epi8(source, zero);
+            __m128i destination_low  = _mm_unpacklo_epi8(destination, zero);
+            __m128i destination_high = _mm_unpackhi_epi8(destination, zero);
+
+            source_low  = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(source_low, tint), full), 8);
+            source_high = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(source_high, tint), full), 8);
+
+            // STEP 3: Each pixel's alpha across its four channels, then source-over
+            __m128i alpha_low  = _mm_shufflehi_epi16(_mm_shufflelo_epi16(source_low, 0xFF), 0xFF);
+            __m128i alpha_high = _mm_shufflehi_epi16(_mm_shufflelo_epi16(source_high, 0xFF), 0xFF);
+
+            __m128i low  = _mm_add_epi16(_mm_mullo_epi16(source_low, alpha_low), _mm_mullo_epi16(destination_low, _mm_sub_epi16(full, alpha_low)));
+            __m128i high = _mm_add_epi16(_mm_mullo_epi16(source_high, alpha_high), _mm_mullo_epi16(destination_high, _mm_sub_epi16(full, alpha_high)));
+            low  = _mm_srli_epi16(_mm_add_epi16(low, full), 8);
+            high = _mm_srli_epi16(_mm_add_epi16(high, full), 8);
+
+            _mm_storeu_si128((__m128i *) (target + i), _mm_packus_epi16(low, high));
+        }
+    }
+#endif
+
+    // Whatever doesn't fill a group of four
+    fill_span_scalar(target, count, texel_row, texel_count, u, du, color, i);
+}
+
+void SoftwareRenderer::read_pixels(std::vector<unsigned char> &pixels)
+{
+    pixels.resize(this->pixels.size() * 4);
+    memcpy(pixels.data(), this->pixels.data(), pixels.size());
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include "Renderer.h"
+
+/**
+ Renderer that draws into an RGBA buffer in memory, needing no GL context.
+ Quads are axis-aligned (as every sprite is), sampled nearest-texel like the
+ game's textures and blended like GL_SRC_ALPHA / GL_ONE_MINUS_SRC_ALPHA.
+ Each row of a quad is one span, filled four pixels at a time with SSE2
+ where it is there; fill_span_scalar() is the tail and the reference, and
+ the two give the same bytes.
+ */
+class SoftwareRenderer : public Renderer {
+private:
+    struct Texture
+    {
+        int width, height;
+        std::vector<uint32_t> texels;   // RGBA bytes, as they sit in memory
+    };
+
+    static bool simd_enabled;
+
+    int width, height;
+    std::vector<uint32_t> pixels;
+
+    std::unordered_map<GLuint, Texture> textures;
+    GLuint next_texture_id = 1;
+    Texture white;   // what texture 0 (a flat quad) samples
+
+    glm::mat4 view_projection = glm::mat4(1.0f);
+    std::vector<SpriteBatch::Sprite> sorted;
+
+    // Animated sprites show the frame for this time; negative follows Animation::now()
+    float time = -1.0f;
+    float frame_time = 0.0f;
+
+    void draw_sprite(const SpriteBatch::Sprite &sprite);
+
+public:
+    // One row of a quad: count pixels from target, texels picked from texel_row at
+    // u, u + du... (in texels), multiplied by color (0-255 RGBA) and blended over target.
+    // The scalar one can start part way along, at pixel first, for the SIMD path's tail
+    static void fill_span(uint32_t *target, int count, const uint32_t *texel_row, int texel_count, float u, float du, const uint16_t color[4]);
+    static void fill_span_scalar(uint32_t *target, int count, const uint32_t *texel_row, int texel_count, float u, float du, const uint16_t color[4], int first = 0);
+
+    // Off sends every span down the scalar path
+    static void set_simd(bool enabled) { simd_enabled = enabled; }
+
+    SoftwareRenderer(int width, int height);
+
+    GLuint create_texture(int width, int height, const unsigned char *pixels) override;
+    void delete_texture(GLuint texture_id) override;
+
+    void begin_frame(const glm::mat4 &view_matrix, const glm::mat4 &projection_matrix, glm::vec4 clear_color) override;
+    void draw_sprites(const SpriteBatch::Sprite *sprites, int count) override;
+    void end_frame() override {}
+
+    void read_pixels(std::vector<unsigned char> &pixels) override;
+
+    // Pins the animation clock, so the same frame always comes out the same
+    void set_time(float time) { this->time = time; }
+
+    int get_width() const override  { return this->width;  }
+    int get_height() const override { return this->height; }
+    const char *get_name() const override { return simd_enabled ? "software (simd)" : "software (scalar)"; }
+};
@@ -0,0 +1,303 @@
+#include "SpriteBatch.h"
+#include "GLState.h"
+#include "RenderStats.h"
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SPRITE_BATCH_SSE 1
+#include <xmmintrin.h>
+#endif
+
+bool SpriteBatch::instancing_enabled = true;
+
+SpriteBatch::~SpriteBatch()
+{
+    GLState::delete_buffer(this->vertex_buffer_id);
+    GLState::delete_buffer(this->quad_buffer_id);
+    GLState::delete_buffer(this->instance_buffer_id);
+}
+
+void SpriteBatch::find_attributes(ShaderProgram *program)
+{
+    this->program = program;
+    
+    this->color_attribute = glGetAttribLocation(program->programID, "vertexColor");
+    this->textured_attribute = glGetAttribLocation(program->programID, "vertexTextured");
+    this->animation_attribute = glGetAttribLocation(program->programID, "animation");
+    this->instance_transform_attribute = glGetAttribLocation(program->programID, "instanceTransform");
+    this->instance_uv_attribute = glGetAttribLocation(program->programID, "instanceUV");
+    
+    // Fall back to the vertex path if the shader is missing the instance attributes
+    this->instanced = this->instance_transform_attribute >= 0 && this->instance_uv_attribute >= 0;
+}
+
+void SpriteBatch::begin()
+{
+    // clear() keeps the capacity, so a steady frame allocates nothing
+    this->sprites.clear();
+    this->draw_calls = 0;
+}
+
+void SpriteBatch::submit(GLuint texture_id, glm::vec3 position, glm::vec3 size, float u, float v, float width, float height, glm::vec4 color, glm::vec4 animation)
+{
+    this->sprites.push_back({ texture_id, position, size, u, v, width, height, color, animation });
+}
+
+void SpriteBatch::flush(ShaderProgram *program)
+{
+    if (this->sprites.empty()) return;
+
+    // Group by texture; stable so draw order within a texture is kept
+    std::stable_sort(this->sprites.begin(), this->sprites.end(),
+                     [](const Sprite &a, const Sprite &b) { return a.texture_id < b.texture_id; });
+
+    if (program != this->program) this->find_attributes(program);
+    
+    if (this->instanced && instancing_enabled)
+    {
+        this->flush_instanced();
+    }
+    else
+    {
+        this->flush_vertices();
+    }
+
+    this->sprites.clear();
+}
+
+void SpriteBatch::expand_vertices_scalar(const Sprite *sprites, int count, float *vertices)
+{
+    for (int i = 0; i < count; i++)
+    {
+        const Sprite &sprite = sprites[i];
+        
+        float left   = sprite.position.x - (sprite.size.x / 2.0f);
+        float right  = sprite.position.x + (sprite.size.x / 2.0f);
+        float bottom = sprite.position.y - (sprite.size.y / 2.0f);
+        float top    = sprite.position.y + (sprite.size.y / 2.0f);
+
+        float u_left   = sprite.u;
+        float u_right  = sprite.u + sprite.width;
+        float v_top    = sprite.v;
+        float v_bottom = sprite.v + sprite.height;
+
+        float textured = sprite.texture_id != 0 ? 1.0f : 0.0f;
+        const glm::vec4 &color = sprite.color;
+        const glm::vec4 &animation = sprite.animation;
+        float *out = vertices + i * FLOATS_PER_SPRITE;
+
+        auto corner = [&](float x, float y, float u, float v) {
+            float vertex[FLOATS_PER_VERTEX] = { x, y, u, v, color.r, color.g, color.b, color.a, textured,
+                                                animation.x, animation.y, animation.z, animation.w };
+            std::copy(vertex, vertex + FLOATS_PER_VERTEX, out);
+            out += FLOATS_PER_VERTEX;
+        };
+
+        // Same winding and UV layout as Entity::draw_sprite_from_texture_atlas
+        corner(left,  bottom, u_left,  v_bottom);
+        corner(right, bottom, u_right, v_bottom);
+        corner(right, top,    u_right, v_top);
+        corner(left,  bottom, u_left,  v_bottom);
+        corner(right, top,    u_right, v_top);
+        corner(left,  top,    u_left,  v_top);
+    }
+}
+
+void SpriteBatch::expand_vertices(const Sprite *sprites, int count, float *vertices)
+{
+    int i = 0;
+    
+#ifdef SPRITE_BATCH_SSE
+    const __m128 half = _mm_set1_ps(0.5f);
+    
+    for (; i + 4 <= count; i += 4)
+    {
+        const Sprite *s = sprites + i;
+        
+        // STEP 1: One lane per sprite
+        __m128 x = _mm_setr_ps(s[0].position.x, s[1].position.x, s[2].position.x, s[3].position.x);
+        __m128 y = _mm_setr_ps(s[0].position.y, s[1].position.y, s[2].position.y, s[3].position.y);
+        __m128 half_width  = _mm_mul_ps(_mm_setr_ps(s[0].size.x, s[1].size.x, s[2].size.x, s[3].size.x), half);
+        __m128 half_height = _mm_mul_ps(_mm_setr_ps(s[0].size.y, s[1].size.y, s[2].size.y, s[3].size.y), half);
+        __m128 u_left   = _mm_setr_ps(s[0].u, s[1].u, s[2].u, s[3].u);
+        __m128 v_top    = _mm_setr_ps(s[0].v, s[1].v, s[2].v, s[3].v);
+        __m128 u_right  = _mm_add_ps(u_left, _mm_setr_ps(s[0].width, s[1].width, s[2].width, s[3].width));
+        __m128 v_bottom = _mm_add_ps(v_top, _mm_setr_ps(s[0].height, s[1].height, s[2].height, s[3].height));
+        
+        __m128 left   = _mm_sub_ps(x, half_width);
+        __m128 right  = _mm_add_ps(x, half_width);
+        __m128 bottom = _mm_sub_ps(y, half_height);
+        __m128 top    = _mm_add_ps(y, half_height);
+        
+        // STEP 2: Transposing (x, y, u, v) across the lanes gives each sprite's corner
+        __m128 left_bottom[4]  = { left,  bottom, u_left,  v_bottom };
+        __m128 right_bottom[4] = { right, bottom, u_right, v_bottom };
+        __m128 right_top[4]    = { right, top,    u_right, v_top    };
+        __m128 left_top[4]     = { left,  top,    u_left,  v_top    };
+        _MM_TRANSPOSE4_PS(left_bottom[0], left_bottom[1], left_bottom[2], left_bottom[3]);
+        _MM_TRANSPOSE4_PS(right_bottom[0], right_bottom[1], right_bottom[2], right_bottom[3]);
+        _MM_TRANSPOSE4_PS(right_top[0], right_top[1], right_top[2], right_top[3]);
+        _MM_TRANSPOSE4_PS(left_top[0], left_top[1], left_top[2], left_top[3]);
+        
+        // STEP 3: Same winding as the scalar path; colour, texture flag and animation after each corner
+        for (int lane = 0; lane < 4; lane++)
+        {
+            float *out = vertices + (i + lane) * FLOATS_PER_SPRITE;
+            __m128 color = _mm_loadu_ps(&s[lane].color[0]);
+            __m128 textured = _mm_set_ss(s[lane].texture_id != 0 ? 1.0f : 0.0f);
+            __m128 animation = _mm_loadu_ps(&s[lane].animation[0]);
+            const __m128 corners[VERTICES_PER_SPRITE] = { left_bottom[lane], right_bottom[lane], right_top[lane],
+                                                          left_bottom[lane], right_top[lane],    left_top[lane] };
+            
+            for (int vertex = 0; vertex < VERTICES_PER_SPRITE; vertex++, out += FLOATS_PER_VERTEX)
+            {
+                _mm_storeu_ps(out, corners[vertex]);
+                _mm_storeu_ps(out + 4, color);
+                _mm_store_ss(out + 8, textured);
+                _mm_storeu_ps(out + 9, animation);
+            }
+        }
+    }
+#endif
+    
+    // Whatever doesn't fill a group of four
+    expand_vertices_scalar(sprites + i, count - i, vertices + i * FLOATS_PER_SPRITE);
+}
+
+void SpriteBatch::flush_vertices()
+{
+    ShaderProgram *program = this->program;
+    
+    // STEP 1: Write every quad straight into world space, so no per-sprite model matrix is needed
+    int sprite_count = (int) this->sprites.size();
+    this->vertices.resize(sprite_count * FLOATS_PER_SPRITE);
+    expand_vertices(this->sprites.data(), sprite_count, this->vertices.data());
+
+    // STEP 2: One upload for the whole frame
+    if (this->vertex_buffer_id == 0) glGenBuffers(1, &this->vertex_buffer_id);
+
+    GLState::bind_array_buffer(this->vertex_buffer_id);
+    glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(float), this->vertices.data(), GL_STREAM_DRAW);
+
+    GLState::set_model_matrix(program, glm::mat4(1.0f));
+    GLState::use_program(program->programID);
+
+    GLsizei stride = FLOATS_PER_VERTEX * sizeof(float);
+    glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, stride, (void *) 0);
+    glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, stride, (void *) (2 * sizeof(float)));
+    if (this->color_attribute >= 0)    glVertexAttribPointer(this->color_attribute, 4, GL_FLOAT, false, stride, (void *) (4 * sizeof(float)));
+    if (this->textured_attribute >= 0) glVertexAttribPointer(this->textured_attribute, 1, GL_FLOAT, false, stride, (void *) (8 * sizeof(float)));
+    if (this->animation_attribute >= 0) glVertexAttribPointer(this->animation_attribute, 4, GL_FLOAT, false, stride, (void *) (9 * sizeof(float)));
+    GLState::use_attributes({ (GLint) program->positionAttribute, (GLint) program->texCoordAttribute,
+                              this->color_attribute, this->textured_attribute, this->animation_attribute });
+
+    // STEP 3: One draw per run of sprites sharing a texture
+    int run_start = 0;
+
+    for (int i = 1; i <= sprite_count; i++)
+    {
+        if (i < sprite_count && this->sprites[i].texture_id == this->sprites[run_start].texture_id) continue;
+
+        GLState::bind_texture(this->sprites[run_start].texture_id);
+        glDrawArrays(GL_TRIANGLES, run_start * VERTICES_PER_SPRITE, (i - run_start) * VERTICES_PER_SPRITE);
+        RenderStats::count_draw((i - run_start) * VERTICES_PER_SPRITE);
+        this->draw_calls++;
+
+        run_start = i;
+    }
+}
+
+void SpriteBatch::flush_instanced()
+{
+    ShaderProgram *program = this->program;
+
+    // STEP 1: The unit quad never changes, so it is uploaded once
+    if (this->quad_buffer_id == 0)
+    {
+        float quad[] =
+        {
+            -0.5, -0.5, 0.0, 1.0,
+             0.5, -0.5, 1.0, 1.0,
+             0.5,  0.5, 1.0, 0.0,
+            -0.5, -0.5, 0.0, 1.0,
+             0.5,  0.5, 1.0, 0.0,
+            -0.5,  0.5, 0.0, 0.0
+        };
+
+        glGenBuffers(1, &this->quad_buffer_id);
+        GLState::bind_array_buffer(this->quad_buffer_id);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    }
+
+    // STEP 2: One 17-float record per sprite instead of 78 floats of corners
+    this->instances.clear();
+    this->instances.reserve(this->sprites.size() * FLOATS_PER_INSTANCE);
+
+    for (const Sprite &sprite : this->sprites)
+    {
+        this->instances.insert(this->instances.end(), {
+            sprite.position.x, sprite.position.y, sprite.size.x, sprite.size.y,
+            sprite.u, sprite.v, sprite.width, sprite.height,
+            sprite.color.r, sprite.color.g, sprite.color.b, sprite.color.a,
+            sprite.texture_id != 0 ? 1.0f : 0.0f,
+            sprite.animation.x, sprite.animation.y, sprite.animation.z, sprite.animation.w
+        });
+    }
+
+    if (this->instance_buffer_id == 0) glGenBuffers(1, &this->instance_buffer_id);
+
+    GLState::bind_array_buffer(this->instance_buffer_id);
+    glBufferData(GL_ARRAY_BUFFER, this->instances.size() * sizeof(float), this->instances.data(), GL_STREAM_DRAW);
+
+    // Instances are already in world space
+    GLState::set_model_matrix(program, glm::mat4(1.0f));
+    GLState::use_program(program->programID);
+
+    GLsizei quad_stride = FLOATS_PER_QUAD_VERTEX * sizeof(float);
+    GLState::bind_array_buffer(this->quad_buffer_id);
+    glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, quad_stride, (void *) 0);
+    glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, quad_stride, (void *) (2 * sizeof(float)));
+
+    GLState::use_attributes({ (GLint) program->positionAttribute, (GLint) program->texCoordAttribute,
+                              this->instance_transform_attribute, this->instance_uv_attribute,
+                              this->color_attribute, this->textured_attribute, this->animation_attribute });
+    glVertexAttribDivisorARB(this->instance_transform_attribute, 1);
+    glVertexAttribDivisorARB(this->instance_uv_attribute, 1);
+    if (this->color_attribute >= 0)     glVertexAttribDivisorARB(this->color_attribute, 1);
+    if (this->textured_attribute >= 0)  glVertexAttribDivisorARB(this->textured_attribute, 1);
+    if (this->animation_attribute >= 0) glVertexAttribDivisorARB(this->animation_attribute, 1);
+
+    // STEP 3: One instanced draw per texture run. GL 2.1 has no base instance,
+    // so the instance attributes are re-pointed at the start of each run
+    GLsizei instance_stride = FLOATS_PER_INSTANCE * sizeof(float);
+    GLState::bind_array_buffer(this->instance_buffer_id);
+
+    int run_start = 0;
+    int sprite_count = (int) this->sprites.size();
+
+    for (int i = 1; i <= sprite_count; i++)
+    {
+        if (i < sprite_count && this->sprites[i].texture_id == this->sprites[run_start].texture_id) continue;
+
+        size_t offset = run_start * instance_stride;
+        glVertexAttribPointer(this->instance_transform_attribute, 4, GL_FLOAT, false, instance_stride, (void *) offset);
+        glVertexAttribPointer(this->instance_uv_attribute, 4, GL_FLOAT, false, instance_stride, (void *) (offset + 4 * sizeof(float)));
+        if (this->color_attribute >= 0)    glVertexAttribPointer(this->color_attribute, 4, GL_FLOAT, false, instance_stride, (void *) (offset + 8 * sizeof(float)));
+        if (this->textured_attribute >= 0) glVertexAttribPointer(this->textured_attribute, 1, GL_FLOAT, false, instance_stride, (void *) (offset + 12 * sizeof(float)));
+        if (this->animation_attribute >= 0) glVertexAttribPointer(this->animation_attribute, 4, GL_FLOAT, false, instance_stride, (void *) (offset + 13 * sizeof(float)));
+
+        GLState::bind_texture(this->sprites[run_start].texture_id);
+        glDrawArraysInstancedARB(GL_TRIANGLES, 0, VERTICES_PER_SPRITE, i - run_start);
+        RenderStats::count_draw(VERTICES_PER_SPRITE, i - run_start);
+        this->draw_calls++;
+
+        run_start = i;
+    }
+
+    // Divisors are global attribute state in a legacy context, so put them back
+    glVertexAttribDivisorARB(this->instance_transform_attribute, 0);
+    glVertexAttribDivisorARB(this->instance_uv_attribute, 0);
+    if (this->color_attribute >= 0)     glVertexAttribDivisorARB(this->color_attribute, 0);
+    if (this->textured_attribute >= 0)  glVertexAttribDivisorARB(this->textured_attribute, 0);
+    if (this->animation_attribute >= 0) glVertexAttribDivisorARB(this->animation_attribute, 0);
+}
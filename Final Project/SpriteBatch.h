@@ -0,0 +1,94 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <vector>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "ShaderProgram.h"
+
+/**
+ Collects quads for a frame and draws them with one buffer upload and one
+ glDrawArrays per texture, instead of one draw per Entity. Every quad carries
+ a colour, and a texture id of 0 makes it a flat-colour quad, so sprites and
+ overlays go through the same batch and program. Animated sprites carry their
+ clip parameters instead of a frame, and the shader picks the frame. When the
+ program has the instance attributes, each sprite is a 17-float instance
+ record drawn over a shared unit quad instead of 6 expanded vertices. Otherwise the corners are
+ written in world space on the CPU, four sprites at a time where SSE is there.
+ */
+class SpriteBatch {
+public:
+    struct Sprite
+    {
+        GLuint texture_id;
+        glm::vec3 position;
+        glm::vec3 size;
+
+        // Frame rectangle in UV space
+        float u, v;
+        float width, height;
+        
+        glm::vec4 color;
+        
+        // (clip, rate, start time, start frame); see Animation. Clip 0 draws the frame rectangle as is
+        glm::vec4 animation;
+    };
+
+private:
+    static bool instancing_enabled;
+
+    std::vector<Sprite> sprites;
+    std::vector<float> vertices;
+
+    GLuint vertex_buffer_id = 0;
+    int draw_calls = 0;
+
+    // Attribute locations, looked up whenever the program changes
+    ShaderProgram *program = NULL;
+    GLint color_attribute = -1;
+    GLint textured_attribute = -1;
+    GLint animation_attribute = -1;
+    
+    // Instanced path: one static unit quad plus one record per sprite
+    bool instanced = false;
+    GLint instance_transform_attribute = -1;
+    GLint instance_uv_attribute = -1;
+    GLuint quad_buffer_id = 0;
+    GLuint instance_buffer_id = 0;
+    std::vector<float> instances;
+
+    void find_attributes(ShaderProgram *program);
+    void flush_vertices();
+    void flush_instanced();
+
+public:
+    static const int FLOATS_PER_VERTEX = 13;
+    static const int VERTICES_PER_SPRITE = 6;
+    static const int FLOATS_PER_INSTANCE = 17;
+    static const int FLOATS_PER_QUAD_VERTEX = 4; // the shared unit quad is (x, y, u, v) only
+    static const int FLOATS_PER_SPRITE = FLOATS_PER_VERTEX * VERTICES_PER_SPRITE;
+
+    // Writes FLOATS_PER_SPRITE floats of world-space corners per sprite into vertices.
+    // expand_vertices() is the SIMD kernel, with expand_vertices_scalar() as its tail and reference
+    static void expand_vertices(const Sprite *sprites, int count, float *vertices);
+    static void expand_vertices_scalar(const Sprite *sprites, int count, float *vertices);
+
+    // Off sends every batch down the CPU pre-transform path
+    static void set_instancing(bool enabled) { instancing_enabled = enabled; }
+
+    ~SpriteBatch();
+
+    void begin();
+    void submit(GLuint texture_id, glm::vec3 position, glm::vec3 size, float u, float v, float width, float height,
+                glm::vec4 color = glm::vec4(1.0f), glm::vec4 animation = glm::vec4(0.0f));
+    void flush(ShaderProgram *program);
+
+    int const get_draw_calls() const { return this->draw_calls; }
+};
@@ -0,0 +1,106 @@
+#include "SpriteBenchmark.h"
+#include "Utility.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+void SpriteBenchmark::expand_with_matrices(const SpriteBatch::Sprite *sprites, int count, float *vertices)
+{
+    // Unit quad corners in the batch's winding, with their UV weights
+    static const float corners[SpriteBatch::VERTICES_PER_SPRITE][4] =
+    {
+        { -0.5f, -0.5f, 0.0f, 1.0f },
+        {  0.5f, -0.5f, 1.0f, 1.0f },
+        {  0.5f,  0.5f, 1.0f, 0.0f },
+        { -0.5f, -0.5f, 0.0f, 1.0f },
+        {  0.5f,  0.5f, 1.0f, 0.0f },
+        { -0.5f,  0.5f, 0.0f, 0.0f }
+    };
+    
+    for (int i = 0; i < count; i++)
+    {
+        const SpriteBatch::Sprite &sprite = sprites[i];
+        
+        glm::mat4 model_matrix = glm::mat4(1.0f);
+        model_matrix = glm::translate(model_matrix, sprite.position);
+        model_matrix = glm::scale(model_matrix, sprite.size);
+        
+        float textured = sprite.texture_id != 0 ? 1.0f : 0.0f;
+        float *out = vertices + i * SpriteBatch::FLOATS_PER_SPRITE;
+        
+        for (const float *corner : corners)
+        {
+            glm::vec4 p = model_matrix * glm::vec4(corner[0], corner[1], 0.0f, 1.0f);
+            float vertex[SpriteBatch::FLOATS_PER_VERTEX] = { p.x, p.y,
+                                                             sprite.u + corner[2] * sprite.width, sprite.v + corner[3] * sprite.height,
+                                                             sprite.color.r, sprite.color.g, sprite.color.b, sprite.color.a, textured,
+                                                             sprite.animation.x, sprite.animation.y, sprite.animation.z, sprite.animation.w };
+            std::copy(vertex, vertex + SpriteBatch::FLOATS_PER_VERTEX, out);
+            out += SpriteBatch::FLOATS_PER_VERTEX;
+        }
+    }
+}
+
+void SpriteBenchmark::run()
+{
+    typedef void (*Expander)(const SpriteBatch::Sprite *, int, float *);
+    
+    struct Path
+    {
+        const char *name;
+        Expander expand;
+    };
+    
+    const Path paths[] =
+    {
+        { "model matrix", expand_with_matrices },
+        { "scalar",       SpriteBatch::expand_vertices_scalar },
+        { "simd",         SpriteBatch::expand_vertices }
+    };
+    
+    const int sprite_counts[] = { 1000, 10000, 100000 };
+    
+    for (int sprite_count : sprite_counts)
+    {
+        // STEP 1: A level's worth of random sprites
+        std::vector<SpriteBatch::Sprite> sprites(sprite_count);
+        for (SpriteBatch::Sprite &sprite : sprites)
+        {
+            sprite.texture_id = 1 + rand() % 4;
+            sprite.position = glm::vec3((float) (rand() % 6200) / 100.0f, -(float) (rand() % 800) / 100.0f, 0.0f);
+            sprite.size = glm::vec3(0.5f + (float) (rand() % 100) / 100.0f, 0.5f + (float) (rand() % 100) / 100.0f, 1.0f);
+            sprite.u = 0.25f * (rand() % 4);
+            sprite.v = 0.25f * (rand() % 4);
+            sprite.width = 0.25f;
+            sprite.height = 0.25f;
+            sprite.color = glm::vec4(1.0f);
+            sprite.animation = glm::vec4(0.0f);
+        }
+        
+        std::vector<float> reference(sprite_count * SpriteBatch::FLOATS_PER_SPRITE);
+        std::vector<float> vertices(sprite_count * SpriteBatch::FLOATS_PER_SPRITE);
+        SpriteBatch::expand_vertices_scalar(sprites.data(), sprite_count, reference.data());
+        
+        // Around a million sprites per path, so the small batches are not all noise
+        int repetitions = std::max(10, 1000000 / sprite_count);
+        
+        LOG(sprite_count << " sprites, " << repetitions << " frames:");
+        
+        // STEP 2: Time each path, and make sure it agrees with the scalar writer
+        for (const Path &path : paths)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < repetitions; i++) path.expand(sprites.data(), sprite_count, vertices.data());
+            auto end = std::chrono::high_resolution_clock::now();
+            
+            float max_error = 0.0f;
+            for (size_t i = 0; i < vertices.size(); i++) max_error = std::max(max_error, fabsf(vertices[i] - reference[i]));
+            
+            double frame_ms = std::chrono::duration<double, std::milli>(end - start).count() / repetitions;
+            LOG("    " << path.name << ": " << frame_ms << " ms per frame, max error " << max_error);
+        }
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include "SpriteBatch.h"
+
+/**
+ Times the ways of getting batched sprites into world space: a model matrix
+ per sprite applied to each corner (what Entity::update and the vertex
+ shader used to do between them), the scalar corner writer, and the SIMD
+ kernel, at a few batch sizes. Run with --bench-sprites; needs no window.
+ */
+class SpriteBenchmark {
+private:
+    static void expand_with_matrices(const SpriteBatch::Sprite *sprites, int count, float *vertices);
+
+public:
+    static void run();
+};
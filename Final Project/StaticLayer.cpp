@@ -0,0 +1,144 @@
+#include "StaticLayer.h"
+#include "GLState.h"
+#include <algorithm>
+#include <cmath>
+
+StaticLayer::~StaticLayer()
+{
+    for (RenderTarget *strip : this->strips) delete strip;
+}
+
+bool StaticLayer::begin(Map *map, Uint64 key)
+{
+    if (this->recorded && map == this->recorded_map && map->get_revision() == this->recorded_map_revision && key == this->recorded_key) return false;
+
+    this->recorded = true;
+    this->recorded_map = map;
+    this->recorded_map_revision = map->get_revision();
+    this->recorded_key = key;
+
+    this->recording.begin();
+    return true;
+}
+
+void StaticLayer::end()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    // A recording the render thread never picked up is simply replaced
+    this->published.swap(this->recording);
+    this->published_left   = this->recorded_map->get_left_bound();
+    this->published_bottom = this->recorded_map->get_bottom_bound();
+    this->published_right  = this->recorded_map->get_right_bound();
+    this->published_top    = this->recorded_map->get_top_bound();
+    this->published_revision++;
+}
+
+bool StaticLayer::pick_up(float *right, float *top)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->published_revision == this->built_revision) return false;
+
+    this->building.swap(this->published);
+    this->built_revision = this->published_revision;
+
+    this->left   = this->published_left;
+    this->bottom = this->published_bottom;
+    *right       = this->published_right;
+    *top         = this->published_top;
+    return true;
+}
+
+void StaticLayer::update(Renderer *renderer, ShaderProgram *program)
+{
+    float right, top;
+    if (!this->pick_up(&right, &top)) return;
+
+    // STEP 1: Enough full-height strips to cover the map left to right
+    int strip_count = std::max(1, (int) ceilf((right - this->left) * TEXELS_PER_UNIT / STRIP_TEXELS));
+    int texture_height = std::max(1, (int) ceilf((top - this->bottom) * TEXELS_PER_UNIT));
+
+    this->strip_width = (float) STRIP_TEXELS / TEXELS_PER_UNIT;
+    this->strip_height = (float) texture_height / TEXELS_PER_UNIT;
+
+    while ((int) this->strips.size() > strip_count)
+    {
+        delete this->strips.back();
+        this->strips.pop_back();
+    }
+    while ((int) this->strips.size() < strip_count) this->strips.push_back(new RenderTarget());
+
+    // STEP 2: Draw the content into them
+    this->redraw(renderer, program, texture_height);
+}
+
+void StaticLayer::redraw(Renderer *renderer, ShaderProgram *program, int texture_height)
+{
+    // STEP 1: This runs inside a frame, so keep what the frame has set up
+    GLint framebuffer_id, viewport[4];
+    GLfloat clear_color[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer_id);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clear_color);
+    glm::mat4 view_matrix = GLState::get_view_matrix(program);
+    glm::mat4 projection_matrix = GLState::get_projection_matrix(program);
+
+    // Resizing binds (and then unbinds) each strip's framebuffer
+    for (RenderTarget *strip : this->strips) strip->resize(STRIP_TEXELS, texture_height);
+
+    // STEP 2: Transparent where there is nothing, with alpha accumulated
+    // rather than squared, so render() can composite the strips premultiplied
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::set_view_matrix(program, glm::mat4(1.0f));
+
+    // STEP 3: The whole recording into each strip; whatever falls outside is clipped
+    for (int i = 0; i < (int) this->strips.size(); i++)
+    {
+        float strip_left = this->left + i * this->strip_width;
+
+        this->strips[i]->bind();
+        glClear(GL_COLOR_BUFFER_BIT);
+        GLState::set_projection_matrix(program, glm::ortho(strip_left, strip_left + this->strip_width, this->bottom, this->bottom + this->strip_height, -1.0f, 1.0f));
+        this->building.flush(renderer);
+    }
+
+    // STEP 4: Back to the frame
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_id);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    GLState::set_view_matrix(program, view_matrix);
+    GLState::set_projection_matrix(program, projection_matrix);
+}
+
+void StaticLayer::render(Renderer *renderer, const Visibility *visibility)
+{
+    if (this->strips.empty()) return;
+
+    this->strip_sprites.clear();
+
+    for (int i = 0; i < (int) this->strips.size(); i++)
+    {
+        glm::vec3 position(this->left + (i + 0.5f) * this->strip_width, this->bottom + this->strip_height / 2.0f, 0.0f);
+        glm::vec3 size(this->strip_width, this->strip_height, 1.0f);
+        if (visibility != NULL && !visibility->contains(position, size)) continue;
+
+        // Target rows run bottom up, so the frame rectangle is flipped
+        this->strip_sprites.push_back({ this->strips[i]->get_texture_id(), position, size, 0.0f, 1.0f, 1.0f, -1.0f, glm::vec4(1.0f), glm::vec4(0.0f) });
+    }
+    if (this->strip_sprites.empty()) return;
+
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    renderer->draw_sprites(this->strip_sprites.data(), (int) this->strip_sprites.size());
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void StaticLayer::draw(Renderer *renderer)
+{
+    float right, top;
+    this->pick_up(&right, &top);
+
+    // Kept until the next recording, so every frame draws the same content
+    this->building.flush(renderer);
+}
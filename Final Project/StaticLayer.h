@@ -0,0 +1,90 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <mutex>
+#include <vector>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "ShaderProgram.h"
+#include "Renderer.h"
+#include "RenderQueue.h"
+#include "RenderTarget.h"
+#include "Map.h"
+#include "Visibility.h"
+
+/**
+ Everything in a level that never moves (the map, blocks, springs) drawn
+ once into a row of offscreen column strips covering the map, so a frame
+ costs one textured quad per visible strip however much static content
+ there is. The scene only records that content again when begin() says it
+ changed: the first time, when the key it passes differs from last time
+ (e.g. which blocks are still there), after invalidate(), or when the
+ map's tiles were edited. The strips are redrawn on the render thread the
+ next time the layer is flushed.
+
+ Strips are drawn unlit and lit when they are drawn into the frame, so
+ lights still move over them. Lights and animated sprites recorded into the
+ layer would freeze, so they belong in the scene's own queue.
+
+ Strips are GL render targets. A renderer without them (SoftwareRenderer)
+ draws the recorded content straight into the frame with draw() instead.
+ */
+class StaticLayer {
+public:
+    // The window's density: 640 pixels over the camera's 10 units
+    static const int TEXELS_PER_UNIT = 64;
+    static const int STRIP_TEXELS = 512;
+
+private:
+    // Simulation thread: what the last recording was made from
+    bool recorded = false;
+    Map *recorded_map = NULL;
+    int recorded_map_revision = 0;
+    Uint64 recorded_key = 0;
+    RenderQueue recording;
+
+    // Handed over by end() and picked up by update()
+    std::mutex mutex;
+    RenderQueue published;
+    float published_left = 0.0f, published_bottom = 0.0f, published_right = 0.0f, published_top = 0.0f;
+    int published_revision = 0;
+
+    // Render thread: the strips and the world rectangle they were drawn over
+    RenderQueue building;
+    int built_revision = 0;
+    std::vector<RenderTarget *> strips;
+    float left = 0.0f, bottom = 0.0f;
+    float strip_width = 0.0f, strip_height = 0.0f;
+    std::vector<SpriteBatch::Sprite> strip_sprites;
+
+    // Render thread: the newest recording into building; false if end() hasn't published since
+    bool pick_up(float *right, float *top);
+    void redraw(Renderer *renderer, ShaderProgram *program, int texture_height);
+
+public:
+    ~StaticLayer();
+
+    // Simulation thread. True when the content has to be recorded again, in
+    // which case record it into get_queue() and call end()
+    bool begin(Map *map, Uint64 key = 0);
+    RenderQueue &get_queue() { return this->recording; }
+    void end();
+
+    // Simulation thread: the next begin() records again whatever the key says
+    void invalidate() { this->recorded = false; }
+
+    // Render thread, before anything is drawn: redraws the strips if end() published since
+    void update(Renderer *renderer, ShaderProgram *program);
+
+    // Render thread: the strips the view overlaps
+    void render(Renderer *renderer, const Visibility *visibility = NULL);
+
+    // Render thread, for a renderer with no strips: the newest recording, drawn as it is
+    void draw(Renderer *renderer);
+};
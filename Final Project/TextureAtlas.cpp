@@ -0,0 +1,155 @@
+#include "TextureAtlas.h"
+#include "Utility.h"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include "stb_image.h"
+
+TextureAtlas::TextureAtlas(int page_size)
+{
+    // Never ask for a page the driver can't hold; a CPU renderer has no such limit
+    GLint max_texture_size = 0;
+    if (Utility::get_texture_renderer() == NULL) glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+
+    this->page_size = (max_texture_size > 0 && page_size > max_texture_size) ? max_texture_size : page_size;
+}
+
+TextureAtlas::~TextureAtlas()
+{
+    for (Image &image : this->images) stbi_image_free(image.pixels);
+    for (GLuint &page : this->pages) Utility::delete_texture(page);
+}
+
+void TextureAtlas::add(const char *filepath)
+{
+    for (const Image &image : this->images) if (image.filepath == filepath) return;
+    if (this->regions.count(filepath) > 0) return;
+
+    Image image;
+    image.filepath = filepath;
+    int number_of_components;
+    image.pixels = stbi_load(filepath, &image.width, &image.height, &number_of_components, STBI_rgb_alpha);
+
+    if (image.pixels == NULL)
+    {
+        LOG("Unable to load image. Make sure the path is correct.");
+        assert(false);
+    }
+
+    if (image.width + 2 * PADDING > this->page_size || image.height + 2 * PADDING > this->page_size)
+    {
+        LOG("Image " << filepath << " does not fit in an atlas page.");
+        assert(false);
+    }
+
+    this->images.push_back(image);
+}
+
+void TextureAtlas::build()
+{
+    // STEP 1: Shelf packing; tallest first keeps the shelves tight
+    std::vector<Image *> order;
+    for (Image &image : this->images) order.push_back(&image);
+    std::sort(order.begin(), order.end(), [](const Image *a, const Image *b) { return a->height > b->height; });
+
+    int first_page = (int) this->pages.size();
+    int page = first_page;
+    int cursor_x = 0, shelf_y = 0, shelf_height = 0;
+    std::vector<int> page_heights(1, 0);
+
+    for (Image *image : order)
+    {
+        int slot_width  = image->width  + 2 * PADDING;
+        int slot_height = image->height + 2 * PADDING;
+
+        // Start a new shelf when this row is full...
+        if (cursor_x + slot_width > this->page_size)
+        {
+            shelf_y += shelf_height;
+            cursor_x = 0;
+            shelf_height = 0;
+        }
+
+        // ...and a new page when the shelves are
+        if (shelf_y + slot_height > this->page_size)
+        {
+            page++;
+            page_heights.push_back(0);
+            cursor_x = 0;
+            shelf_y = 0;
+            shelf_height = 0;
+        }
+
+        image->page = page;
+        image->x = cursor_x + PADDING;
+        image->y = shelf_y + PADDING;
+
+        cursor_x += slot_width;
+        shelf_height = std::max(shelf_height, slot_height);
+        page_heights.back() = std::max(page_heights.back(), shelf_y + shelf_height);
+    }
+
+    // STEP 2: Compose each page on the CPU, then upload it once
+    for (int i = 0; i < (int) page_heights.size(); i++)
+    {
+        if (page_heights[i] == 0) continue;
+
+        // Pages are only as tall as their shelves
+        int page_height = page_heights[i];
+        std::vector<unsigned char> page_pixels(this->page_size * page_height * 4, 0);
+
+        for (const Image &image : this->images)
+        {
+            if (image.page != first_page + i) continue;
+
+            // Extrude the border texels into the padding so neighbours never bleed in
+            for (int y = -PADDING; y < image.height + PADDING; y++)
+            {
+                int source_y = std::min(std::max(y, 0), image.height - 1);
+                for (int x = -PADDING; x < image.width + PADDING; x++)
+                {
+                    int source_x = std::min(std::max(x, 0), image.width - 1);
+                    const unsigned char *source = &image.pixels[(source_y * image.width + source_x) * 4];
+                    unsigned char *target = &page_pixels[((image.y + y) * this->page_size + (image.x + x)) * 4];
+                    std::copy(source, source + 4, target);
+                }
+            }
+
+            this->regions[image.filepath] = AtlasRegion(0,
+                                                        (float) image.x / this->page_size,
+                                                        (float) image.y / page_height,
+                                                        (float) image.width / this->page_size,
+                                                        (float) image.height / page_height);
+        }
+
+        this->upload_page(page_pixels);
+
+        for (auto &region : this->regions)
+        {
+            if (region.second.texture_id == 0) region.second.texture_id = this->pages.back();
+        }
+    }
+
+    // STEP 3: The pixels live on the GPU now
+    for (Image &image : this->images) stbi_image_free(image.pixels);
+    this->images.clear();
+}
+
+void TextureAtlas::upload_page(std::vector<unsigned char> &page_pixels)
+{
+    int page_height = (int) page_pixels.size() / (this->page_size * 4);
+
+    this->pages.push_back(Utility::upload_texture(this->page_size, page_height, page_pixels.data()));
+}
+
+AtlasRegion const TextureAtlas::get_region(const char *filepath) const
+{
+    auto region = this->regions.find(filepath);
+    if (region == this->regions.end())
+    {
+        LOG("Image " << filepath << " was never added to the atlas.");
+        return AtlasRegion();
+    }
+
+    return region->second;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <map>
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include <SDL_opengl.h>
+
+/**
+ A sub-rectangle of a GL texture in UV space. A bare texture id converts to
+ a region covering the whole texture, so standalone textures still work.
+ */
+struct AtlasRegion
+{
+    GLuint texture_id;
+    float u, v;
+    float width, height;
+
+    AtlasRegion(GLuint texture_id = 0) : texture_id(texture_id), u(0.0f), v(0.0f), width(1.0f), height(1.0f) {}
+    AtlasRegion(GLuint texture_id, float u, float v, float width, float height)
+        : texture_id(texture_id), u(u), v(v), width(width), height(height) {}
+};
+
+/**
+ Packs every image a scene needs into as few GL textures ("pages") as
+ possible at load time, using a shelf packer, so sprites from different
+ image files can share one bind and one batch.
+ */
+class TextureAtlas {
+private:
+    struct Image
+    {
+        std::string filepath;
+        int width, height;
+        unsigned char *pixels;
+
+        // Placement, filled in by build()
+        int page, x, y;
+    };
+
+    int page_size;
+    std::vector<Image> images;
+    std::vector<GLuint> pages;
+    std::map<std::string, AtlasRegion> regions;
+
+    void upload_page(std::vector<unsigned char> &page_pixels);
+
+public:
+    static const int DEFAULT_PAGE_SIZE = 2048;
+    static const int PADDING = 2; // texels of edge extrusion around every image
+
+    TextureAtlas(int page_size = DEFAULT_PAGE_SIZE);
+    ~TextureAtlas();
+
+    void add(const char *filepath);
+    void build();
+
+    AtlasRegion const get_region(const char *filepath) const;
+    int         const get_page_count() const { return (int) this->pages.size(); }
+};
@@ -6,9 +6,14 @@
 #define FONTBANK_SIZE 16
 
 #include "Utility.h"
+#include "Renderer.h"
+#include "GLState.h"
+#include "RenderStats.h"
 #include <SDL_image.h>
 #include "stb_image.h"
 
+Renderer *Utility::texture_renderer = NULL;
+
 GLuint Utility::load_texture(const char* filepath) {
     // STEP 1: Loading the image file
     int width, height, number_of_components;
@@ -20,37 +25,79 @@ GLuint Utility::load_texture(const char* filepath) {
         assert(false);
     }
     
-    // STEP 2: Generating and binding a texture ID to our image
+    // STEP 2: Generating a texture ID for our image
+    GLuint texture_id = upload_texture(width, height, image, GL_REPEAT); // the last argument can change depending on what you are looking for
+    
+    // STEP 3: Releasing our file from memory and returning our texture id
+    stbi_image_free(image);
+    
+    return texture_id;
+}
+
+GLuint Utility::upload_texture(int width, int height, const unsigned char *pixels, GLint wrap_mode)
+{
+    // The CPU renderer samples nearest and clamps, whatever the mode
+    if (texture_renderer != NULL) return texture_renderer->create_texture(width, height, pixels);
+    
+    // STEP 1: Generating and binding a texture ID to the pixels
     GLuint texture_id;
     glGenTextures(NUMBER_OF_TEXTURES, &texture_id);
-    glBindTexture(GL_TEXTURE_2D, texture_id);
-    glTexImage2D(GL_TEXTURE_2D, LEVEL_OF_DETAIL, GL_RGBA, width, height, TEXTURE_BORDER, GL_RGBA, GL_UNSIGNED_BYTE, image);
+    GLState::bind_texture(texture_id);
+    glTexImage2D(GL_TEXTURE_2D, LEVEL_OF_DETAIL, GL_RGBA, width, height, TEXTURE_BORDER, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
     
-    // STEP 3: Setting our texture filter modes
+    // STEP 2: Setting our texture filter modes
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     
-    // STEP 4: Setting our texture wrapping modes
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT); // the last argument can change depending on what you are looking for
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    
-    // STEP 5: Releasing our file from memory and returning our texture id
-    stbi_image_free(image);
+    // STEP 3: Setting our texture wrapping modes
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_mode);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_mode);
     
     return texture_id;
 }
 
-void Utility::draw_text(ShaderProgram *program, GLuint font_texture_id, std::string text, float screen_size, float spacing, glm::vec3 position)
+void Utility::delete_texture(GLuint &texture_id)
 {
+    if (texture_renderer == NULL)
+    {
+        GLState::delete_texture(texture_id);
+        return;
+    }
+    
+    if (texture_id != 0) texture_renderer->delete_texture(texture_id);
+    texture_id = 0;
+}
+
+std::unordered_map<std::string, std::vector<Utility::TextMesh>> Utility::text_meshes;
+int Utility::text_mesh_count = 0;
+
+const Utility::TextMesh &Utility::get_text_mesh(GLuint font_texture_id, const std::string &text, float screen_size, float spacing)
+{
+    // Looking up by the caller's string allocates nothing on a hit
+    auto entry = text_meshes.find(text);
+    if (entry != text_meshes.end())
+    {
+        for (const TextMesh &mesh : entry->second)
+        {
+            if (mesh.font_texture_id == font_texture_id && mesh.screen_size == screen_size && mesh.spacing == spacing) return mesh;
+        }
+    }
+
+    // Strings that change every frame would otherwise grow the cache forever
+    if (text_mesh_count >= MAX_TEXT_MESHES)
+    {
+        clear_text_cache();
+        entry = text_meshes.end();
+    }
+
     // Scale the size of the fontbank in the UV-plane
     // We will use this for spacing and positioning
     float width = 1.0f / FONTBANK_SIZE;
     float height = 1.0f / FONTBANK_SIZE;
 
-    // Instead of having a single pair of arrays, we'll have a series of pairs—one for each character
-    // Don't forget to include <vector>!
+    // One interleaved (x, y, u, v) array for the whole string
     std::vector<float> vertices;
-    std::vector<float> texture_coordinates;
+    vertices.reserve(text.size() * 6 * 4);
 
     // For every character...
     for (int i = 0; i < text.size(); i++) {
@@ -63,41 +110,80 @@ void Utility::draw_text(ShaderProgram *program, GLuint font_texture_id, std::str
         float u_coordinate = (float) (spritesheet_index % FONTBANK_SIZE) / FONTBANK_SIZE;
         float v_coordinate = (float) (spritesheet_index / FONTBANK_SIZE) / FONTBANK_SIZE;
 
-        // 3. Inset the current pair in both vectors
+        // 3. Append the character's two triangles
         vertices.insert(vertices.end(), {
-            offset + (-0.5f * screen_size), 0.5f * screen_size,
-            offset + (-0.5f * screen_size), -0.5f * screen_size,
-            offset + (0.5f * screen_size), 0.5f * screen_size,
-            offset + (0.5f * screen_size), -0.5f * screen_size,
-            offset + (0.5f * screen_size), 0.5f * screen_size,
-            offset + (-0.5f * screen_size), -0.5f * screen_size,
+            offset + (-0.5f * screen_size),  0.5f * screen_size, u_coordinate,         v_coordinate,
+            offset + (-0.5f * screen_size), -0.5f * screen_size, u_coordinate,         v_coordinate + height,
+            offset + ( 0.5f * screen_size),  0.5f * screen_size, u_coordinate + width, v_coordinate,
+            offset + ( 0.5f * screen_size), -0.5f * screen_size, u_coordinate + width, v_coordinate + height,
+            offset + ( 0.5f * screen_size),  0.5f * screen_size, u_coordinate + width, v_coordinate,
+            offset + (-0.5f * screen_size), -0.5f * screen_size, u_coordinate,         v_coordinate + height,
         });
+    }
 
-        texture_coordinates.insert(texture_coordinates.end(), {
-            u_coordinate, v_coordinate,
-            u_coordinate, v_coordinate + height,
-            u_coordinate + width, v_coordinate,
-            u_coordinate + width, v_coordinate + height,
-            u_coordinate + width, v_coordinate,
-            u_coordinate, v_coordinate + height,
-        });
+    // 4. Upload once; later frames only draw it
+    TextMesh mesh = { font_texture_id, screen_size, spacing, 0, (int) (text.size() * 6) };
+    glGenBuffers(1, &mesh.vertex_buffer_id);
+    GLState::bind_array_buffer(mesh.vertex_buffer_id);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+
+    text_mesh_count++;
+    std::vector<TextMesh> &meshes = (entry != text_meshes.end()) ? entry->second : text_meshes[text];
+    meshes.push_back(mesh);
+
+    return meshes.back();
+}
+
+void Utility::get_text_sprites(GLuint font_texture_id, const std::string &text, float screen_size, float spacing, glm::vec3 position, std::vector<SpriteBatch::Sprite> &sprites)
+{
+    sprites.clear();
+    
+    float width = 1.0f / FONTBANK_SIZE;
+    float height = 1.0f / FONTBANK_SIZE;
+    
+    // The same cells and offsets as get_text_mesh(), each glyph centred on its offset
+    for (int i = 0; i < text.size(); i++)
+    {
+        int spritesheet_index = (int) text[i];
+        float u_coordinate = (float) (spritesheet_index % FONTBANK_SIZE) / FONTBANK_SIZE;
+        float v_coordinate = (float) (spritesheet_index / FONTBANK_SIZE) / FONTBANK_SIZE;
+        
+        sprites.push_back({ font_texture_id, position + glm::vec3(spacing * i, 0.0f, 0.0f), glm::vec3(screen_size, screen_size, 1.0f),
+                            u_coordinate, v_coordinate, width, height, glm::vec4(1.0f), glm::vec4(0.0f) });
     }
+}
+
+void Utility::draw_text(ShaderProgram *program, GLuint font_texture_id, const std::string &text, float screen_size, float spacing, glm::vec3 position)
+{
+    if (text.empty()) return;
+
+    const TextMesh &mesh = get_text_mesh(font_texture_id, text, screen_size, spacing);
 
-    // 4. And render all of them using the pairs
     glm::mat4 model_matrix = glm::mat4(1.0f);
     model_matrix = glm::translate(model_matrix, position);
     
-    program->SetModelMatrix(model_matrix);
-    glUseProgram(program->programID);
-    
-    glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, vertices.data());
-    glEnableVertexAttribArray(program->positionAttribute);
-    glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, texture_coordinates.data());
-    glEnableVertexAttribArray(program->texCoordAttribute);
+    GLState::set_model_matrix(program, model_matrix);
+    GLState::use_program(program->programID);
     
-    glBindTexture(GL_TEXTURE_2D, font_texture_id);
-    glDrawArrays(GL_TRIANGLES, 0, (int) (text.size() * 6));
+    GLsizei stride = 4 * sizeof(float);
+    GLState::bind_array_buffer(mesh.vertex_buffer_id);
+    glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, stride, (void *) 0);
+    glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, stride, (void *) (2 * sizeof(float)));
+    GLState::use_attributes({ (GLint) program->positionAttribute, (GLint) program->texCoordAttribute });
     
-    glDisableVertexAttribArray(program->positionAttribute);
-    glDisableVertexAttribArray(program->texCoordAttribute);
+    GLState::bind_texture(font_texture_id);
+    glDrawArrays(GL_TRIANGLES, 0, mesh.vertex_count);
+    RenderStats::count_draw(mesh.vertex_count);
+    RenderStats::count_glyphs((int) text.size());
+}
+
+void Utility::clear_text_cache()
+{
+    for (auto &entry : text_meshes)
+    {
+        for (TextMesh &mesh : entry.second) GLState::delete_buffer(mesh.vertex_buffer_id);
+    }
+
+    text_meshes.clear();
+    text_mesh_count = 0;
 }
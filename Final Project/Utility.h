@@ -6,15 +6,56 @@
 #endif
 
 #define GL_GLEXT_PROTOTYPES 1
+#include <iostream>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <SDL.h>
 #include <SDL_opengl.h>
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
+#include "SpriteBatch.h"
+
+#define LOG(argument) std::cout << argument << '\n'
+
+class Renderer;
 
 class Utility {
+private:
+    // Where textures go when there is no GL context; NULL means GL
+    static Renderer *texture_renderer;
+
+    // Glyph quads for one string in one font/size/spacing, kept in a static VBO
+    struct TextMesh
+    {
+        GLuint font_texture_id;
+        float screen_size, spacing;
+        GLuint vertex_buffer_id;
+        int vertex_count;
+    };
+
+    static std::unordered_map<std::string, std::vector<TextMesh>> text_meshes;
+    static int text_mesh_count;
+
+    static const TextMesh &get_text_mesh(GLuint font_texture_id, const std::string &text, float screen_size, float spacing);
+
 public:
+    static const int MAX_TEXT_MESHES = 128; // past this the cache is dropped and rebuilt on demand
+
+    // Every texture the game creates goes through these, so scenes load the same
+    // way into GL or into a renderer of their own (see set_texture_renderer())
     static GLuint load_texture(const char* filepath);
-    static void draw_text(ShaderProgram *program, GLuint font_texture_id, std::string text, float screen_size, float spacing, glm::vec3 position);
+    static GLuint upload_texture(int width, int height, const unsigned char *pixels, GLint wrap_mode = GL_CLAMP_TO_EDGE);
+    static void delete_texture(GLuint &texture_id);
+
+    // With a renderer set, textures are that renderer's and nothing is uploaded to
+    // GL, so levels load with no context (see --headless)
+    static void set_texture_renderer(Renderer *renderer) { texture_renderer = renderer; }
+    static Renderer *get_texture_renderer() { return texture_renderer; }
+
+    // One sprite per glyph, laid out the way draw_text() lays them out
+    static void get_text_sprites(GLuint font_texture_id, const std::string &text, float screen_size, float spacing, glm::vec3 position, std::vector<SpriteBatch::Sprite> &sprites);
+    static void draw_text(ShaderProgram *program, GLuint font_texture_id, const std::string &text, float screen_size, float spacing, glm::vec3 position);
+    static void clear_text_cache();
 };
@@ -0,0 +1,41 @@
+#include "Visibility.h"
+#include "glm/matrix.hpp"
+#include <cmath>
+#include <algorithm>
+
+void Visibility::update(const glm::mat4 &view_matrix, const glm::mat4 &projection_matrix)
+{
+    // Push the corners of clip space back through both matrices to get the world rectangle
+    glm::mat4 clip_to_world = glm::inverse(projection_matrix * view_matrix);
+    glm::vec4 bottom_left = clip_to_world * glm::vec4(-1.0f, -1.0f, 0.0f, 1.0f);
+    glm::vec4 top_right   = clip_to_world * glm::vec4( 1.0f,  1.0f, 0.0f, 1.0f);
+    
+    this->left   = std::min(bottom_left.x, top_right.x);
+    this->right  = std::max(bottom_left.x, top_right.x);
+    this->bottom = std::min(bottom_left.y, top_right.y);
+    this->top    = std::max(bottom_left.y, top_right.y);
+    
+    this->entities_drawn = 0;
+    this->entities_culled = 0;
+    this->columns_drawn = 0;
+    this->columns_culled = 0;
+}
+
+bool const Visibility::contains(glm::vec3 position, glm::vec3 size) const
+{
+    float half_width  = fabs(size.x) / 2.0f;
+    float half_height = fabs(size.y) / 2.0f;
+    
+    return position.x + half_width  >= this->left   && position.x - half_width  <= this->right &&
+           position.y + half_height >= this->bottom && position.y - half_height <= this->top;
+}
+
+bool Visibility::test(glm::vec3 position, glm::vec3 size)
+{
+    bool visible = this->contains(position, size);
+    
+    if (visible) this->entities_drawn++;
+    else         this->entities_culled++;
+    
+    return visible;
+}
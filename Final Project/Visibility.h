@@ -0,0 +1,27 @@
+#pragma once
+#include <cmath>
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+/**
+ The world-space rectangle the camera can see this frame, plus counters of
+ what was drawn and what was skipped against it.
+ */
+class Visibility {
+public:
+    float left   = -INFINITY,
+          right  =  INFINITY,
+          bottom = -INFINITY,
+          top    =  INFINITY;
+    
+    // Profiling counters; reset by every update()
+    int entities_drawn = 0;
+    int entities_culled = 0;
+    int columns_drawn = 0;
+    int columns_culled = 0;
+    
+    void update(const glm::mat4 &view_matrix, const glm::mat4 &projection_matrix);
+    bool test(glm::vec3 position, glm::vec3 size);
+    
+    bool const contains(glm::vec3 position, glm::vec3 size) const;
+};
@@ -22,12 +22,28 @@
 #include "Entity.h"
 #include "Map.h"
 #include "Utility.h"
+#include "GLState.h"
+#include "ShaderCache.h"
+#include "ShaderSources.h"
+#include "RenderThread.h"
+#include "RenderStats.h"
+#include "SpriteBenchmark.h"
+#include "RenderBenchmark.h"
+#include "GLRenderer.h"
+#include "SoftwareRenderer.h"
+#include "Effects.h"
+#include "DynamicResolution.h"
+#include "FrameCapture.h"
+#include "Lighting.h"
+#include "Animation.h"
 #include "Scene.h"
 #include "LevelA.h"
 #include "LevelB.h"
 #include "LevelC.h"
 #include "Intro.h"
 #include <chrono>
+#include <algorithm>
+#include <cstring>
 /**
  CONSTANTS
  */
@@ -44,11 +60,13 @@ const int VIEWPORT_X = 0,
           VIEWPORT_WIDTH  = WINDOW_WIDTH,
           VIEWPORT_HEIGHT = WINDOW_HEIGHT;
 
-const char V_SHADER_PATH[] = "shaders/vertex_textured.glsl",
-           F_SHADER_PATH[] = "shaders/fragment_textured.glsl";
-
 const float MILLISECONDS_IN_SECOND = 1000.0;
 
+// Dynamic resolution: the scene never drops below half size, and aims to fit a 60 Hz frame
+const float MIN_RESOLUTION_SCALE = 0.5f,
+            MAX_RESOLUTION_SCALE = 1.0f,
+            FRAME_BUDGET_MS      = 1000.0f / 60.0f;
+
 /**
  VARIABLES
  */
@@ -60,10 +78,35 @@ LevelC *level_c;
 Intro *start_menu;
 
 SDL_Window* display_window;
+SDL_GLContext gl_context;
 bool game_is_running = true;
 
+// Draws on its own thread unless started with --single-thread
+RenderThread render_thread;
+
+Effects *effects;
+
+// Point lights for everything below the HUD
+Lighting *lighting;
+
+// Render thread only; NULL when started with --fixed-resolution
+DynamicResolution *dynamic_resolution = NULL;
+bool use_dynamic_resolution = true;
+
+// F9 starts and stops recording; render thread only. --capture-ppm writes images instead of video
+FrameCapture *frame_capture = NULL;
+CaptureFormat capture_format = CAPTURE_Y4M;
+bool capture_requested = false;
+
+// F3 toggles the render stats overlay, drawn with its own copy of the font
+bool show_render_stats = false;
+GLuint stats_font_texture_id;
+
+// Maps, text, sprites and flat quads all share this one program, and scenes'
+// queues are flushed through this renderer over it
 ShaderProgram program;
-glm::mat4 view_matrix, projection_matrix;
+GLRenderer *gl_renderer;
+glm::mat4 view_matrix, previous_view_matrix, projection_matrix;
 
 float previous_ticks = 0.0f;
 float accumulator = 0.0f;
@@ -74,7 +117,12 @@ auto t_end = std::chrono::high_resolution_clock::now();
 void switch_to_scene(Scene *scene)
 {
     current_scene = scene;
-    current_scene->initialise();
+    
+    // Loading creates textures and buffers, so it has to happen where the context is
+    render_thread.run([scene]() {
+        Animation::clear();
+        scene->initialise();
+    });
 }
 
 void initialise()
@@ -85,8 +133,8 @@ void initialise()
                                       WINDOW_WIDTH, WINDOW_HEIGHT,
                                       SDL_WINDOW_OPENGL);
     
-    SDL_GLContext context = SDL_GL_CreateContext(display_window);
-    SDL_GL_MakeCurrent(display_window, context);
+    gl_context = SDL_GL_CreateContext(display_window);
+    SDL_GL_MakeCurrent(display_window, gl_context);
     
 #ifdef _WINDOWS
     glewInit();
@@ -94,15 +142,34 @@ void initialise()
     
     glViewport(VIEWPORT_X, VIEWPORT_Y, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
     
-    program.Load(V_SHADER_PATH, F_SHADER_PATH);
+    ShaderCache::load(program, VERTEX_UBER_SHADER_SOURCE, FRAGMENT_UBER_SHADER_SOURCE);
+    
+    // What the uber-shader reads for attributes a draw leaves off: a white,
+    // textured, unanimated quad with an identity instance transform
+    GLState::set_attribute_default(glGetAttribLocation(program.programID, "vertexColor"), glm::vec4(1.0f));
+    GLState::set_attribute_default(glGetAttribLocation(program.programID, "vertexTextured"), glm::vec4(1.0f));
+    GLState::set_attribute_default(glGetAttribLocation(program.programID, "instanceTransform"), glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+    GLState::set_attribute_default(glGetAttribLocation(program.programID, "instanceUV"), glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+    GLState::set_attribute_default(glGetAttribLocation(program.programID, "animation"), glm::vec4(0.0f));
+    
+    // Starts the animation clock before either thread reads it
+    Animation::apply(&program);
     
     view_matrix = glm::mat4(1.0f);
+    previous_view_matrix = view_matrix;
     projection_matrix = glm::ortho(-5.0f, 5.0f, -3.75f, 3.75f, -1.0f, 1.0f);
     
-    program.SetProjectionMatrix(projection_matrix);
-    program.SetViewMatrix(view_matrix);
+    GLState::set_projection_matrix(&program, projection_matrix);
+    GLState::set_view_matrix(&program, view_matrix);
     
-    glUseProgram(program.programID);
+    GLState::use_program(program.programID);
+    
+    gl_renderer = new GLRenderer(&program, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+    effects = new Effects(VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+    lighting = new Lighting(&program);
+    if (use_dynamic_resolution) dynamic_resolution = new DynamicResolution(MIN_RESOLUTION_SCALE, MAX_RESOLUTION_SCALE, FRAME_BUDGET_MS);
+    frame_capture = new FrameCapture(VIEWPORT_WIDTH, VIEWPORT_HEIGHT, capture_format);
+    stats_font_texture_id = Utility::load_texture("assets/texture/font1.png");
     
     glClearColor(BG_RED, BG_BLUE, BG_GREEN, BG_OPACITY);
     
@@ -122,6 +189,20 @@ void initialise()
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
+glm::mat4 camera_for(glm::vec3 player_position)
+{
+    // Prevent the camera from showing anything outside of the "edge" of the level
+    glm::mat4 camera = glm::mat4(1.0f);
+    
+    if (player_position.x > LEVEL1_LEFT_EDGE) {
+        camera = glm::translate(camera, glm::vec3(-player_position.x, 3.75, 0));
+    } else {
+        camera = glm::translate(camera, glm::vec3(-5, 3.75, 0));
+    }
+    
+    return camera;
+}
+
 void process_input()
 {
     // VERY IMPORTANT: If nothing is pressed, we don't want to go anywhere
@@ -144,6 +225,14 @@ void process_input()
                         game_is_running = false;
                         break;
                     }
+                    case SDLK_F3:{
+                        show_render_stats = !show_render_stats;
+                        break;
+                    }
+                    case SDLK_F9:{
+                        capture_requested = !capture_requested;
+                        break;
+                    }
                     case SDLK_SPACE:{
                         // Jump
                         if (current_scene->state.player->jumping_count < 1)
@@ -194,7 +283,7 @@ void process_input()
     }
 }
 
-void update()
+bool update()
 {
     float ticks = (float)SDL_GetTicks() / MILLISECONDS_IN_SECOND;
     float delta_time = ticks - previous_ticks;
@@ -205,11 +294,12 @@ void update()
     if (delta_time < FIXED_TIMESTEP)
     {
         accumulator = delta_time;
-        return;
+        return false;
     }
     
     while (delta_time >= FIXED_TIMESTEP) {
         current_scene->update(FIXED_TIMESTEP);
+        effects->update(FIXED_TIMESTEP);
         
         delta_time -= FIXED_TIMESTEP;
     }
@@ -226,36 +316,165 @@ void update()
         }
     }
     
+    // The camera follows the player, so it interpolates between the same two steps
+    view_matrix = camera_for(current_scene->state.player->get_position());
+    previous_view_matrix = camera_for(current_scene->state.player->get_previous_position());
     
-    // Prevent the camera from showing anything outside of the "edge" of the level
-    view_matrix = glm::mat4(1.0f);
+    return true;
+}
+
+void record(FrameSnapshot &snapshot)
+{
+    // Anything outside this rectangle is skipped before it reaches GL
+    current_scene->visibility.update(view_matrix, projection_matrix);
     
-    if (current_scene->state.player->get_position().x > LEVEL1_LEFT_EDGE) {
-        view_matrix = glm::translate(view_matrix, glm::vec3(-current_scene->state.player->get_position().x, 3.75, 0));
-    } else {
-        view_matrix = glm::translate(view_matrix, glm::vec3(-5, 3.75, 0));
-    }
+    Uint64 render_start = SDL_GetPerformanceCounter();
+    current_scene->render_queue.begin();
+    current_scene->render(&program);
+    snapshot.scene_render_ms = RenderStats::elapsed_ms(render_start, SDL_GetPerformanceCounter());
+    snapshot.show_stats = show_render_stats;
+    snapshot.capture = capture_requested;
+    
+    snapshot.queue.swap(current_scene->render_queue);
+    snapshot.view_matrix = view_matrix;
+    snapshot.previous_view_matrix = previous_view_matrix;
+    snapshot.batch = &current_scene->sprite_batch;
+    snapshot.post_process = effects->get_post_process();
+    
+    // How far past the last step the simulation clock already was
+    snapshot.alpha = accumulator / FIXED_TIMESTEP;
+    snapshot.recorded_at = SDL_GetPerformanceCounter();
 }
 
-void render()
+void draw(FrameSnapshot &snapshot)
 {
-    program.SetViewMatrix(view_matrix);
+    // Present the state that lies between the last two steps at this moment;
+    // the render thread can draw a snapshot more than once, so time keeps moving
+    float elapsed = (float) (SDL_GetPerformanceCounter() - snapshot.recorded_at) / (float) SDL_GetPerformanceFrequency();
+    float alpha = std::min(snapshot.alpha + elapsed / FIXED_TIMESTEP, 1.0f);
     
+    glm::mat4 interpolated_view_matrix = snapshot.previous_view_matrix + (snapshot.view_matrix - snapshot.previous_view_matrix) * alpha;
+    
+    GLState::reset_counters();
+    RenderStats::begin_frame();
+    RenderStats::set_scene_render_time(snapshot.scene_render_ms);
+    
+    GLState::set_view_matrix(&program, interpolated_view_matrix);
+    Animation::apply(&program);
+    
+    // With any effect running, or below full resolution, the scene goes
+    // offscreen first and is composited (and upscaled) once
+    if (dynamic_resolution != NULL)
+    {
+        effects->set_resolution_scale(dynamic_resolution->get_scale());
+        dynamic_resolution->begin_frame();
+    }
+    effects->begin(snapshot.post_process);
     glClear(GL_COLOR_BUFFER_BIT);
     
-    current_scene->render(&program);
+    Uint64 flush_start = SDL_GetPerformanceCounter();
+    // The light grid covers exactly what this frame shows
+    Visibility view;
+    view.update(interpolated_view_matrix, projection_matrix);
+    lighting->set_view(view);
+    
+    snapshot.queue.flush(gl_renderer, alpha, lighting);
+    effects->end(snapshot.post_process);
+    float flush_ms = RenderStats::elapsed_ms(flush_start, SDL_GetPerformanceCounter());
+    RenderStats::set_flush_time(flush_ms);
+    
+    if (dynamic_resolution != NULL)
+    {
+        RenderStats::set_resolution(dynamic_resolution->get_scale(), dynamic_resolution->get_gpu_ms());
+        dynamic_resolution->end_frame(flush_ms);
+    }
+    
+    // Before the overlay, so recordings show only the game. The readback only
+    // starts here; the pixels are collected a couple of frames later
+    frame_capture->set_recording(snapshot.capture);
+    if (frame_capture->is_recording())
+    {
+        Uint64 capture_start = SDL_GetPerformanceCounter();
+        frame_capture->capture_frame();
+        RenderStats::set_capture_time(RenderStats::elapsed_ms(capture_start, SDL_GetPerformanceCounter()));
+    }
+    
+    // On top of the effects, so a fade never hides the numbers
+    if (snapshot.show_stats) RenderStats::render_overlay(&program, snapshot.batch, stats_font_texture_id);
     
+    Uint64 swap_start = SDL_GetPerformanceCounter();
     SDL_GL_SwapWindow(display_window);
+    RenderStats::set_swap_time(RenderStats::elapsed_ms(swap_start, SDL_GetPerformanceCounter()));
+}
+
+void render()
+{
+    // Serial fallback: record and draw on this thread
+    FrameSnapshot &snapshot = render_thread.get_back_snapshot();
+    record(snapshot);
+    draw(snapshot);
 }
 
 void shutdown()
 {
-    SDL_Quit();
+    // Takes the context back onto this thread
+    render_thread.stop();
     
+    // Scenes own GL buffers, so free them while the context is still alive
     delete start_menu;
     delete level_a;
     delete level_b;
     delete level_c;
+    delete effects;
+    delete lighting;
+    delete dynamic_resolution;
+    delete frame_capture;
+    delete gl_renderer;
+    
+    // The overlay's font came from Utility::load_texture, so it goes back the same way
+    Utility::delete_texture(stats_font_texture_id);
+    Utility::clear_text_cache();
+    ShaderCache::clear();
+    
+    SDL_Quit();
+}
+
+void render_headless(const char *image_filepath)
+{
+    // STEP 1: No window, no context and no sound; textures belong to the CPU renderer
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    SoftwareRenderer renderer(VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+    renderer.set_time(0.0f);
+    Utility::set_texture_renderer(&renderer);
+    
+    // STEP 2: The first level as it opens, before any step, so nothing depends on the clock
+    Animation::clear();
+    level_a = new LevelA();
+    current_scene = level_a;
+    current_scene->initialise();
+    
+    view_matrix = camera_for(current_scene->state.player->get_position());
+    projection_matrix = glm::ortho(-5.0f, 5.0f, -3.75f, 3.75f, -1.0f, 1.0f);
+    
+    // STEP 3: Recorded the way record() records it, and flushed through the CPU renderer
+    current_scene->visibility.update(view_matrix, projection_matrix);
+    current_scene->render_queue.begin();
+    current_scene->render(&program);
+    
+    renderer.begin_frame(view_matrix, projection_matrix, glm::vec4(BG_RED, BG_BLUE, BG_GREEN, BG_OPACITY));
+    current_scene->render_queue.flush(&renderer);
+    renderer.end_frame();
+    
+    // STEP 4: The same build always writes the same image, so it can be diffed against a saved one
+    if (image_filepath != NULL)
+    {
+        std::vector<unsigned char> frame;
+        renderer.read_pixels(frame);
+        RenderBenchmark::write_ppm(image_filepath, frame, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+    }
+    
+    delete level_a;
+    Utility::set_texture_renderer(NULL);
 }
 
 /**
@@ -263,16 +482,81 @@ void shutdown()
  */
 int main(int argc, char* argv[])
 {
+    bool threaded = true;
+    bool bench_render = false;
+    const char *bench_image_filepath = NULL;
+    
+    for (int i = 1; i < argc; i++)
+    {
+        // An optional file name after --headless or --bench-render gets the frame as a PPM
+        const char *next = (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) ? argv[i + 1] : NULL;
+        
+        if (strcmp(argv[i], "--single-thread") == 0) threaded = false;
+        if (strcmp(argv[i], "--no-instancing") == 0) SpriteBatch::set_instancing(false);
+        if (strcmp(argv[i], "--fixed-resolution") == 0) use_dynamic_resolution = false;
+        if (strcmp(argv[i], "--capture-ppm") == 0) capture_format = CAPTURE_PPM;
+        
+        // CPU only; report and leave before a window is ever opened
+        if (strcmp(argv[i], "--bench-sprites") == 0)
+        {
+            SpriteBenchmark::run();
+            return 0;
+        }
+        
+        // The CPU rasterizer alone, for machines with no GPU: the benchmark, then a real level
+        if (strcmp(argv[i], "--headless") == 0)
+        {
+            RenderBenchmark::run_headless(VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+            render_headless(next);
+            return 0;
+        }
+        
+        if (strcmp(argv[i], "--bench-render") == 0)
+        {
+            bench_render = true;
+            bench_image_filepath = next;
+        }
+    }
+    
     initialise();
     
+    // GL against the CPU rasterizer, in the window, before the game starts
+    if (bench_render)
+    {
+        RenderBenchmark::run_gl(&program, VIEWPORT_WIDTH, VIEWPORT_HEIGHT, bench_image_filepath);
+        shutdown();
+        return 0;
+    }
+    
+    if (threaded) render_thread.start(display_window, gl_context, draw);
+    
     while (game_is_running)
     {
         process_input();
-        update();
         
-        if (current_scene->state.next_scene_id >= 0) switch_to_scene(levels[current_scene->state.next_scene_id]);
+        bool stepped = update();
         
-        render();
+        if (current_scene->state.next_scene_id >= 0)
+        {
+            switch_to_scene(levels[current_scene->state.next_scene_id]);
+            stepped = true;
+        }
+        
+        if (!render_thread.is_running())
+        {
+            render();
+        }
+        else if (stepped)
+        {
+            // Hand the new state over and get straight on with the next step
+            record(render_thread.get_back_snapshot());
+            render_thread.publish();
+        }
+        else
+        {
+            // Nothing to simulate yet; don't spin a core waiting for the next step
+            SDL_Delay(1);
+        }
     }
     
     shutdown();
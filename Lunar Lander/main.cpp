@@ -76,6 +76,13 @@ glm::mat4 view_matrix, projection_matrix;
 float previous_ticks = 0.0f;
 float accumulator = 0.0f;
 
+// The platforms never move, so they are drawn once into a texture covering the
+// view and that one quad is drawn every frame instead of all of them. Set
+// static_layer_dirty whenever a platform changes and they are drawn again
+GLuint static_framebuffer_id = 0;
+GLuint static_texture_id = 0;
+bool static_layer_dirty = true;
+
 /**
  GENERAL FUNCTIONS
  */
@@ -111,6 +118,78 @@ GLuint load_texture(const char* filepath)
     return textureID;
 }
 
+void create_static_layer()
+{
+    // STEP 1: A window-sized colour texture, so the view maps onto it texel for pixel
+    glGenTextures(NUMBER_OF_TEXTURES, &static_texture_id);
+    glBindTexture(GL_TEXTURE_2D, static_texture_id);
+    glTexImage2D(GL_TEXTURE_2D, LEVEL_OF_DETAIL, GL_RGBA, VIEWPORT_WIDTH, VIEWPORT_HEIGHT, TEXTURE_BORDER, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    
+    // STEP 2: Attached to a framebuffer of its own
+    glGenFramebuffers(1, &static_framebuffer_id);
+    glBindFramebuffer(GL_FRAMEBUFFER, static_framebuffer_id);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, static_texture_id, LEVEL_OF_DETAIL);
+    
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        LOG("Unable to create the platform layer.");
+        assert(false);
+    }
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void redraw_static_layer()
+{
+    // STEP 1: Transparent where there are no platforms. Alpha is accumulated
+    // rather than squared, so the texture comes out premultiplied
+    glBindFramebuffer(GL_FRAMEBUFFER, static_framebuffer_id);
+    glViewport(0, 0, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    
+    // STEP 2: Same camera as the window, so every platform lands where it would have
+    for (int i = 0; i < PLATFORM_COUNT; i++) state.platforms[i].render(&program);
+    
+    // STEP 3: Back to the window
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glClearColor(BG_RED, BG_BLUE, BG_GREEN, BG_OPACITY);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(VIEWPORT_X, VIEWPORT_Y, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+    
+    static_layer_dirty = false;
+}
+
+void draw_static_layer()
+{
+    // The whole view, as set by the projection matrix. Texture rows run bottom
+    // up, the same way as the vertices
+    float vertices[]   = { -5.0f, -3.75f, 5.0f, -3.75f, 5.0f, 3.75f, -5.0f, -3.75f, 5.0f, 3.75f, -5.0f, 3.75f };
+    float tex_coords[] = {  0.0f,  0.0f,  1.0f,  0.0f,  1.0f, 1.0f,  0.0f,  0.0f,  1.0f, 1.0f,  0.0f, 1.0f };
+    
+    program.SetModelMatrix(glm::mat4(1.0f));
+    glBindTexture(GL_TEXTURE_2D, static_texture_id);
+    
+    glVertexAttribPointer(program.positionAttribute, 2, GL_FLOAT, false, 0, vertices);
+    glEnableVertexAttribArray(program.positionAttribute);
+    glVertexAttribPointer(program.texCoordAttribute, 2, GL_FLOAT, false, 0, tex_coords);
+    glEnableVertexAttribArray(program.texCoordAttribute);
+    
+    // Premultiplied by redraw_static_layer()
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    
+    glDisableVertexAttribArray(program.positionAttribute);
+    glDisableVertexAttribArray(program.texCoordAttribute);
+}
+
 void initialise()
 {
     SDL_Init(SDL_INIT_VIDEO);
@@ -241,6 +320,8 @@ void initialise()
     
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    
+    create_static_layer();
 }
 
 void process_input()
@@ -343,6 +424,8 @@ void update()
 
 void render()
 {
+    if (static_layer_dirty) redraw_static_layer();
+    
     glClear(GL_COLOR_BUFFER_BIT);
     
     state.player->render(&program);
@@ -355,13 +438,16 @@ void render()
         state.text_fail->render(&program);
     }
     
-    for (int i = 0; i < PLATFORM_COUNT; i++) state.platforms[i].render(&program);
+    draw_static_layer();
     
     SDL_GL_SwapWindow(display_window);
 }
 
 void shutdown()
 {
+    glDeleteFramebuffers(1, &static_framebuffer_id);
+    glDeleteTextures(NUMBER_OF_TEXTURES, &static_texture_id);
+    
     SDL_Quit();
     
     delete[] state.platforms;
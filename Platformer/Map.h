@@ -31,13 +31,15 @@ private:
     int tile_count_x;
     int tile_count_y;
     
-    std::vector<float> vertices;
-    std::vector<float> texture_coordinates;
+    // Interleaved x, y, u, v per vertex; lives on the GPU once build() has run
+    GLuint vertex_buffer_id = 0;
+    int vertex_count = 0;
     
     float left_bound, right_bound, top_bound, bottom_bound;
     
 public:
     Map(int width, int height, unsigned int *level_data, GLuint texture_id, float tile_size, int tile_count_x, int tile_count_y);
+    ~Map();
     
     void build();
     void render(ShaderProgram *program);
@@ -54,8 +56,8 @@ public:
     int const get_tile_count_x() {return this->tile_count_x;}
     int const get_tile_count_y() {return this->tile_count_y;}
     
-    std::vector<float> const get_vertices()             const {return this->vertices;           }
-    std::vector<float> const get_texuture_coordinates() const {return this->texture_coordinates;}
+    GLuint const get_vertex_buffer_id() const {return this->vertex_buffer_id;}
+    int    const get_vertex_count()     const {return this->vertex_count;    }
     
     float const get_left_bound() const {return this->left_bound;    }
     float const get_right_bound() const {return this->right_bound;  }
@@ -22,8 +22,17 @@ Map::Map(int width, int height, unsigned int *level_data, GLuint texture_id, flo
     this->build();
 }
 
+Map::~Map()
+{
+    glDeleteBuffers(1, &this->vertex_buffer_id);
+}
+
 void Map::build()
 {
+    // CPU-side staging only; once it is on the GPU we let these go
+    std::vector<float> vertices;
+    std::vector<float> texture_coordinates;
+    
     for(int y = 0; y < this->height; y++)
     {
         for(int x = 0; x < this->width; x++)
@@ -41,7 +50,7 @@ void Map::build()
             float x_offset = -(this->tile_size / 2);
             float y_offset = (this->tile_size / 2);
             
-            this->vertices.insert(vertices.end(), {
+            vertices.insert(vertices.end(), {
                 x_offset + (this->tile_size * x), y_offset + -this->tile_size * y,
                 x_offset + (this->tile_size * x), y_offset + (-this->tile_size * y) - this->tile_size,
                 x_offset + (this->tile_size * x) + this->tile_size, y_offset + (-this->tile_size * y) - this->tile_size,
@@ -50,7 +59,7 @@ void Map::build()
                 x_offset + (this->tile_size * x) + this->tile_size, y_offset + -this->tile_size * y
             });
             
-            this->texture_coordinates.insert(texture_coordinates.end(), {
+            texture_coordinates.insert(texture_coordinates.end(), {
                 u, v,
                 u, v + (tile_height),
                 u + tile_width, v + (tile_height),
@@ -61,6 +70,25 @@ void Map::build()
         }
     }
     
+    // Interleave position and UV so one buffer holds the whole level
+    this->vertex_count = (int) vertices.size() / 2;
+    
+    std::vector<float> interleaved;
+    interleaved.reserve(this->vertex_count * 4);
+    for (int i = 0; i < this->vertex_count; i++)
+    {
+        interleaved.insert(interleaved.end(), {
+            vertices[i * 2], vertices[i * 2 + 1],
+            texture_coordinates[i * 2], texture_coordinates[i * 2 + 1]
+        });
+    }
+    
+    if (this->vertex_buffer_id == 0) glGenBuffers(1, &this->vertex_buffer_id);
+    
+    glBindBuffer(GL_ARRAY_BUFFER, this->vertex_buffer_id);
+    glBufferData(GL_ARRAY_BUFFER, interleaved.size() * sizeof(float), interleaved.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    
     this->left_bound = 0 - (this->tile_size / 2);
     this->right_bound = (this->tile_size * this->width) - (this->tile_size / 2);
     this->top_bound = 0 + (this->tile_size / 2);
@@ -74,16 +102,25 @@ void Map::render(ShaderProgram *program)
     
     glUseProgram(program->programID);
     
-    glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, this->vertices.data());
+    if (this->vertex_count == 0) return;
+    
+    // Attribute pointers are offsets into the buffer, not client memory
+    GLsizei stride = 4 * sizeof(float);
+    glBindBuffer(GL_ARRAY_BUFFER, this->vertex_buffer_id);
+    
+    glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, stride, (void *) 0);
     glEnableVertexAttribArray(program->positionAttribute);
-    glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, this->texture_coordinates.data());
+    glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, stride, (void *) (2 * sizeof(float)));
     glEnableVertexAttribArray(program->texCoordAttribute);
     
     glBindTexture(GL_TEXTURE_2D, this->texture_id);
     
-    glDrawArrays(GL_TRIANGLES, 0, (int) this->vertices.size() / 2);
+    glDrawArrays(GL_TRIANGLES, 0, this->vertex_count);
     glDisableVertexAttribArray(program->positionAttribute);
     glDisableVertexAttribArray(program->texCoordAttribute);
+    
+    // Everything else still draws from client-side arrays
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 bool Map::is_solid(glm::vec3 position, float *penetration_x, float *penetration_y)